@@ -160,6 +160,21 @@ void fillRectData(uint8_t* fb_ptr, fb_var_screeninfo vinfo, fb_fix_screeninfo fi
 }
 
 // 화면 업데이트 함수
+void updateRect(uint8_t* fb_ptr, uint8_t* buffer_ptr, fb_var_screeninfo vinfo, fb_fix_screeninfo finfo, int x, int y, int w, int h) {
+    for (int j = 0; j < h; ++j) {
+        for (int i = 0; i < w; ++i) {
+            int px = x + i;
+            int py = y + j;
+            if (px < 0 || px >= WIDTH || py < 0 || py >= HEIGHT) {
+                continue;
+            }
+            long location = (px + vinfo.xoffset) * (vinfo.bits_per_pixel / 8) +
+                            (py + vinfo.yoffset) * finfo.line_length;
+            *((FIXEL_FORMAT*)(fb_ptr + location)) = *((FIXEL_FORMAT*)(buffer_ptr + location));
+        }
+    }
+}
+
 void updateScreen(uint8_t* fb_ptr, uint8_t* buffer_ptr, fb_var_screeninfo vinfo, fb_fix_screeninfo finfo) {
     for (int y = 0; y < HEIGHT; ++y) {
         for (int x = 0; x < WIDTH; ++x) {
@@ -0,0 +1,4171 @@
+#include <iostream>
+#include <fcntl.h>
+#include <linux/fb.h>
+#include <linux/input.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+#include <cstring>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <new>
+#include <atomic>
+#include <bitset>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+// 터미널 설정을 비활성화하여 입력을 화면에 표시되지 않도록 합니다.
+void disableInputEcho() {
+    struct termios tty;
+    tcgetattr(STDIN_FILENO, &tty); // 현재 터미널 속성 가져오기
+    tty.c_lflag &= ~ECHO; // ECHO 플래그를 끄기
+    tcsetattr(STDIN_FILENO, TCSANOW, &tty); // 변경된 속성 설정
+}
+
+// 터미널 설정을 원래대로 복원하여 입력을 다시 화면에 표시되도록 합니다.
+void enableInputEcho() {
+    struct termios tty;
+    tcgetattr(STDIN_FILENO, &tty); // 현재 터미널 속성 가져오기
+    tty.c_lflag |= ECHO; // ECHO 플래그를 켜기
+    tcsetattr(STDIN_FILENO, TCSANOW, &tty); // 변경된 속성 설정
+}
+
+#if !defined(uint8_t)
+#define uint8_t unsigned char
+#endif
+#if !defined(uint16_t)
+#define uint16_t unsigned short
+#endif
+#if !defined(uint32_t)
+#define uint32_t unsigned int
+#endif
+
+// 힙 할당 횟수 (매 프레임 할당이 없는지 확인하는 용도)
+std::atomic<size_t> g_heapAllocCount(0);
+
+// 모든 operator new/delete가 이 두 함수를 거칩니다 (크기/정렬/nothrow 버전 포함).
+// Surface처럼 직접 잡는 버퍼도 malloc/aligned_alloc 대신 countedAlloc으로 잡고 countedFree로 풀어서 함께 셉니다.
+// 인라인되면 GCC가 new로 받은 포인터를 free한다고 -Wmismatched-new-delete 경고를 내므로 막아 둡니다.
+__attribute__((noinline)) void* countedAlloc(size_t size, size_t align) {
+    g_heapAllocCount.fetch_add(1, std::memory_order_relaxed);
+    size = size == 0 ? 1 : size;
+    if (align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        return malloc(size);
+    }
+    return aligned_alloc(align, (size + align - 1) & ~(align - 1));
+}
+__attribute__((noinline)) void countedFree(void* ptr) noexcept {
+    free(ptr);
+}
+
+void* operator new(size_t size) {
+    void* ptr = countedAlloc(size, 0);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+void* operator new(size_t size, std::align_val_t align) {
+    void* ptr = countedAlloc(size, (size_t)align);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+void* operator new[](size_t size, std::align_val_t align) {
+    return operator new(size, align);
+}
+void* operator new(size_t size, const std::nothrow_t &) noexcept {
+    return countedAlloc(size, 0);
+}
+void* operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return countedAlloc(size, 0);
+}
+void* operator new(size_t size, std::align_val_t align, const std::nothrow_t &) noexcept {
+    return countedAlloc(size, (size_t)align);
+}
+void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t &) noexcept {
+    return countedAlloc(size, (size_t)align);
+}
+void operator delete(void* ptr) noexcept {
+    countedFree(ptr);
+}
+void operator delete[](void* ptr) noexcept {
+    countedFree(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept {
+    countedFree(ptr);
+}
+void operator delete[](void* ptr, size_t) noexcept {
+    countedFree(ptr);
+}
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    countedFree(ptr);
+}
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    countedFree(ptr);
+}
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    countedFree(ptr);
+}
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+    countedFree(ptr);
+}
+void operator delete(void* ptr, const std::nothrow_t &) noexcept {
+    countedFree(ptr);
+}
+void operator delete[](void* ptr, const std::nothrow_t &) noexcept {
+    countedFree(ptr);
+}
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    countedFree(ptr);
+}
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    countedFree(ptr);
+}
+
+// 프레임 단위 임시 메모리 (bump allocator)
+// 시작할 때 한 번만 할당하고 매 프레임 reset()으로 통째로 비웁니다.
+class FrameArena {
+private:
+    uint8_t* base;
+    size_t capacity;
+    size_t offset = 0;
+    size_t peak = 0;
+
+public:
+    FrameArena(size_t size) : base((uint8_t*)countedAlloc(size, 0)), capacity(size) {}
+    ~FrameArena() {
+        countedFree(base);
+    }
+
+    void* alloc(size_t size, size_t align = 16) {
+        size_t start = (offset + align - 1) & ~(align - 1);
+        if (start + size > capacity) {
+            return nullptr;
+        }
+        offset = start + size;
+        if (offset > peak) {
+            peak = offset;
+        }
+        return base + start;
+    }
+
+    template <typename T>
+    T* allocArray(int count) {
+        return (T*)alloc(sizeof(T) * count, alignof(T));
+    }
+
+    void reset() {
+        offset = 0;
+    }
+
+    size_t used() const { return offset; }
+    size_t peakUsed() const { return peak; }
+};
+
+// 고정 크기 오브젝트 풀
+// 슬롯은 미리 잡아두고 free list로 재사용하므로 create/destroy에 힙 할당이 없습니다.
+template <typename T, int N>
+class Pool {
+private:
+    alignas(T) uint8_t storage[N * sizeof(T)];
+    int freeList[N];
+    int freeCount = N;
+    bool used[N];
+
+    T* slot(int index) {
+        return (T*)(storage + index * sizeof(T));
+    }
+
+public:
+    Pool() {
+        for (int i = 0; i < N; ++i) {
+            freeList[i] = N - 1 - i;
+            used[i] = false;
+        }
+    }
+    ~Pool() {
+        for (int i = 0; i < N; ++i) {
+            if (used[i]) {
+                slot(i)->~T();
+            }
+        }
+    }
+
+    template <typename... Args>
+    T* create(Args&&... args) {
+        if (freeCount == 0) {
+            return nullptr;
+        }
+        int index = freeList[--freeCount];
+        used[index] = true;
+        return new (slot(index)) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T* obj) {
+        int index = (int)(obj - slot(0));
+        obj->~T();
+        used[index] = false;
+        freeList[freeCount++] = index;
+    }
+
+    template <typename F>
+    void forEach(F f) {
+        for (int i = 0; i < N; ++i) {
+            if (used[i]) {
+                f(*slot(i));
+            }
+        }
+    }
+
+    int size() const { return N - freeCount; }
+    int capacity() const { return N; }
+};
+
+// 고정 개수의 작업 스레드
+// 스레드는 시작할 때 한 번만 만들고, run()마다 인덱스를 나눠 가져가며 작업합니다.
+// 호출한 스레드도 함께 일하므로 스레드 수가 1이면 그냥 순서대로 실행됩니다.
+class WorkerPool {
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    void (*task)(void*, int) = nullptr;
+    void* taskContext = nullptr;
+    int taskCount = 0;
+    std::atomic<int> nextIndex;
+    int pending = 0;
+    uint32_t generation = 0;
+    bool stopping = false;
+
+    void runTasks() {
+        int index;
+        while ((index = nextIndex.fetch_add(1)) < taskCount) {
+            task(taskContext, index);
+        }
+    }
+
+    void workerLoop() {
+        uint32_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+            }
+            runTasks();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--pending == 0) {
+                    finished.notify_one();
+                }
+            }
+        }
+    }
+
+public:
+    WorkerPool(int threadCount) : nextIndex(0) {
+        for (int i = 1; i < threadCount; ++i) {
+            threads.emplace_back(&WorkerPool::workerLoop, this);
+        }
+    }
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+    }
+
+    int size() const { return (int)threads.size() + 1; }
+
+    void run(int count, void (*fn)(void*, int), void* context) {
+        if (threads.empty() || count <= 1) {
+            for (int i = 0; i < count; ++i) {
+                fn(context, i);
+            }
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = fn;
+            taskContext = context;
+            taskCount = count;
+            nextIndex.store(0);
+            pending = (int)threads.size();
+            generation++;
+        }
+        wake.notify_all();
+        runTasks();
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&] { return pending == 0; });
+    }
+
+    template <typename F>
+    void parallelFor(int count, F &fn) {
+        run(count, [](void* context, int index) { (*(F*)context)(index); }, &fn);
+    }
+};
+
+// 기준 화면 크기 (헤드리스 화면, 배치 좌표의 기준)
+const int DEFAULT_SCREEN_WIDTH = 1280;
+const int DEFAULT_SCREEN_HEIGHT = 720;
+// --scale auto에서 내부 해상도의 높이가 이보다 작아지지 않는 가장 큰 배율을 고릅니다.
+const int MIN_AUTO_RENDER_HEIGHT = 240;
+
+// 내부 렌더 해상도
+// 시작할 때 화면 크기(vinfo.xres/yres)를 배율로 나눠 setRenderSize()로 정합니다.
+int WIDTH = DEFAULT_SCREEN_WIDTH;
+int HEIGHT = DEFAULT_SCREEN_HEIGHT;
+int GROUND_LEVEL = (HEIGHT - 50);
+
+// 기준 화면 좌표를 내부 해상도로 바꿉니다.
+inline int layoutX(int x) {
+    return x * WIDTH / DEFAULT_SCREEN_WIDTH;
+}
+
+inline int layoutY(int y) {
+    return y * HEIGHT / DEFAULT_SCREEN_HEIGHT;
+}
+
+void setRenderSize(int width, int height) {
+    WIDTH = width;
+    HEIGHT = height;
+    GROUND_LEVEL = HEIGHT - layoutY(50);
+}
+
+const int BOUND_GRAVITY = -10;
+// 물리는 60Hz 한 틱을 시간 단위로 씁니다. 속도는 틱당 픽셀, 중력은 틱당 속도 증가입니다.
+const int SIM_TICK_HZ = 60;
+const int GRAVITY = 1;
+// 한 스텝에서 충돌을 처리하고 남은 시간을 다시 이동하는 최대 횟수
+const int MAX_SWEEP_ITERATIONS = 4;
+// 물리 월드를 작업 스레드에 나눠 맡기는 단위와 구간마다 기록할 수 있는 접촉 수
+const int PHYSICS_CHUNK = 2048;
+const int MAX_CONTACTS_PER_BODY = 4;
+// 여러 월드 일괄 진행 (WorldBatch)에서 작업 스레드 하나가 맡는 월드 수 (4의 배수)
+const int WORLD_CHUNK = 1024;
+// 봇 입력이 바뀌는 주기 (틱)
+const int BOT_INPUT_TICKS = 30;
+
+// 기본 레벨: 오른쪽으로 갈수록 높아지는 블록
+const int LEVEL_BLOCKS = 10;
+const int LEVEL_BLOCK_WIDTH = 50;
+const int LEVEL_BLOCK_HEIGHT = 10;
+const int PLAYER_MOVE_SPEED = 5;
+
+// 엔티티/프레임 메모리 한도
+const int MAX_BLOCKS = 64;
+const int MAX_DIRTY_RECTS = MAX_BLOCKS + 8;
+const int MAX_PARTICLES = 4096;
+const int DUST_PER_BOUNCE = 32;
+const int TEXT_CACHE_RUNS = 16;
+const int TEXT_RUN_MAX_CHARS = 48;
+// 화면 왼쪽 위 상태 표시 영역
+const int HUD_X = 8;
+const int HUD_Y = 8;
+const int HUD_SCALE = 2;
+const int HUD_LINES = 4;
+const int MAX_COLLISION_PAIRS = MAX_BLOCKS * 4;
+const int MAX_DRAW_COMMANDS = 1024;
+const int MAX_ATLAS_REGIONS = 64;
+const int MAX_ASSETS = 64;
+const int MAX_CLIP_DEPTH = 16;
+const size_t SURFACE_ALIGN = 64;
+// 델타 출력에서 지난 프레임과 비교하는 단위 (캐시 라인 하나)
+const int DELTA_CHUNK_BYTES = 64;
+const int MAX_ANIMATION_FRAMES = 16;
+const int ROLL_PIXELS_PER_FRAME = 8;
+// 확대/회전 그리기에서 한 번에 샘플링하는 픽셀 수
+const int SAMPLE_CHUNK = 64;
+// 공이 튀어 오를 때 찌그러지는 정도 (프레임 수, 최대 비율 %)
+const int SQUASH_FRAMES = 8;
+const int SQUASH_PERCENT = 30;
+// 다각형 채우기가 받는 최대 꼭짓점 수
+const int MAX_POLYGON_VERTICES = 64;
+// 속도 벡터를 몇 틱 앞까지 그릴지
+const int DEBUG_VELOCITY_TICKS = 4;
+// 팔레트 배경 (--palette): 하늘 띠에 쓰는 팔레트 구간과 순환 주기
+const int PALETTE_GROUND = 1;
+const int PALETTE_SKY_FIRST = 16;
+const int PALETTE_SKY_SHADES = 16;
+const int PALETTE_CYCLE_FRAMES = 4;
+const int SKY_BAND_HEIGHT = 8;
+const size_t FRAME_ARENA_SIZE = 1 << 20;
+// 이 프레임 이후로는 힙 할당이 없어야 합니다.
+const uint32_t WARMUP_FRAMES = 2;
+
+
+// #define USE_FIXEL_FORMAT_32
+
+#if defined(USE_FIXEL_FORMAT_32)
+#define FIXEL_FORMAT uint32_t
+    #define ARGB8888
+    // #define RGBA8888
+#else
+#define FIXEL_FORMAT uint16_t
+#endif
+
+struct Color {
+    uint8_t r, g, b, a;
+};
+
+FIXEL_FORMAT convertTo(Color color) {
+    #if defined(USE_FIXEL_FORMAT_32)
+    #if defined(RGBA8888)
+    return (color.r << 24) | (color.g << 16) | (color.b << 8) | color.a;
+    #elif defined(ARGB8888)
+    return ((255 - color.a) << 24) | (color.r << 16) | (color.g << 8) | color.b;
+    #else
+        #err
+    #endif
+    #else
+    // 16비트 rgb565
+    return ((color.r & 0xF8) << 8) | ((color.g & 0xFC) << 3) | (color.b >> 3);
+    #endif
+}
+
+// convertTo의 반대 (녹화한 프레임을 BMP로 저장할 때)
+Color convertFrom(FIXEL_FORMAT pixel) {
+    #if defined(USE_FIXEL_FORMAT_32)
+    #if defined(RGBA8888)
+    return {(uint8_t)(pixel >> 24), (uint8_t)(pixel >> 16), (uint8_t)(pixel >> 8), (uint8_t)pixel};
+    #else
+    return {(uint8_t)(pixel >> 16), (uint8_t)(pixel >> 8), (uint8_t)pixel, (uint8_t)(255 - (pixel >> 24))};
+    #endif
+    #else
+    uint8_t r = (pixel >> 11) & 0x1F, g = (pixel >> 5) & 0x3F, b = pixel & 0x1F;
+    return {(uint8_t)((r << 3) | (r >> 2)), (uint8_t)((g << 2) | (g >> 4)), (uint8_t)((b << 3) | (b >> 2)), 0};
+    #endif
+}
+
+// 마스크의 가장 낮은 비트 위치
+int maskShift(uint32_t mask) {
+    int shift = 0;
+    while (mask != 0 && (mask & 1) == 0) {
+        mask >>= 1;
+        shift++;
+    }
+    return shift;
+}
+
+class Image {
+public:
+    int width = 0, height = 0;
+    FIXEL_FORMAT* data = nullptr;
+    // 32비트 BMP처럼 알파가 있는 이미지는 premultiplied ARGB8888로도 보관합니다.
+    uint32_t* pixels = nullptr;
+
+    // 빈 이미지 (코드로 직접 채우는 용도)
+    Image(int w, int h) : width(w), height(h) {
+        data = new FIXEL_FORMAT[width * height];
+        pixels = new uint32_t[width * height];
+        memset(data, 0, sizeof(FIXEL_FORMAT) * width * height);
+        memset(pixels, 0, sizeof(uint32_t) * width * height);
+    }
+
+    // 픽셀이 아직 없는 이미지 (AssetLoader가 읽은 파일을 decode로 채웁니다)
+    Image() {}
+
+    Image(const char * imagePath) {
+        FILE * bmp = fopen(imagePath, "rb");
+        if (bmp == nullptr) {
+            std::cerr << "Error: cannot open image file " << imagePath << "." << std::endl;
+            return;
+        }
+        fseek(bmp, 0, SEEK_END);
+        long size = std::max(0L, ftell(bmp));
+        fseek(bmp, 0, SEEK_SET);
+        uint8_t * file = new uint8_t[size + 1];
+        size_t got = fread(file, sizeof(uint8_t), size, bmp);
+        fclose(bmp);
+        decode(file, got, imagePath);
+        delete[] file;
+    }
+
+    // 메모리에 읽어 둔 BMP 파일을 변환합니다. 다른 이미지와 공유하는 상태가 없어 어느 스레드에서 불러도 됩니다.
+    bool decode(const uint8_t * file, size_t size, const char * imagePath) {
+        // BITMAPFILEHEADER(14) + BITMAPINFOHEADER(40) + 비트필드 마스크(16)
+        uint8_t header[70];
+        memset(header, 0, sizeof(header));
+        memcpy(header, file, std::min(size, sizeof(header)));
+
+        int dataOffset = *(int*)&header[10];
+        int rawHeight = *(int*)&header[22];
+        int bitsPerPixel = *(uint16_t*)&header[28];
+        int compression = *(int*)&header[30];
+        if (bitsPerPixel != 24 && bitsPerPixel != 32) {
+            std::cerr << "Error: unsupported bmp format " << bitsPerPixel << "bpp in " << imagePath << "." << std::endl;
+            return false;
+        }
+        width = *(int*)&header[18];
+        height = rawHeight < 0 ? -rawHeight : rawHeight;
+
+        // 행은 4바이트 단위로 패딩되고, 높이가 양수면 아래 행부터 저장됩니다.
+        int bytesPerPixel = bitsPerPixel / 8;
+        int rowBytes = (width * bytesPerPixel + 3) & ~3;
+        if (width <= 0 || dataOffset < 0 || (size_t)dataOffset + (size_t)rowBytes * height > size) {
+            std::cerr << "Error: truncated bmp file " << imagePath << "." << std::endl;
+            width = height = 0;
+            return false;
+        }
+        const uint8_t * bmpdata = file + dataOffset;
+
+        uint32_t redMask = 0x00FF0000, greenMask = 0x0000FF00, blueMask = 0x000000FF, alphaMask = 0xFF000000;
+        if (bitsPerPixel == 32 && compression == 3) { // BI_BITFIELDS
+            redMask = *(uint32_t*)&header[54];
+            greenMask = *(uint32_t*)&header[58];
+            blueMask = *(uint32_t*)&header[62];
+            alphaMask = *(uint32_t*)&header[66];
+        }
+
+        // 알파가 전부 0이면 알파를 쓰지 않는 32비트 파일로 봅니다.
+        bool hasAlpha = false;
+        if (bitsPerPixel == 32 && alphaMask != 0) {
+            for (int i = 0; i < width * height && !hasAlpha; i++) {
+                hasAlpha = (*(uint32_t*)&bmpdata[(i / width) * rowBytes + (i % width) * 4] & alphaMask) != 0;
+            }
+        }
+
+        // bmp to FIXEL_FORMAT
+        data = new FIXEL_FORMAT[width * height];
+        if (hasAlpha) {
+            pixels = new uint32_t[width * height];
+        }
+        for (int y = 0; y < height; y++) {
+            const uint8_t * row = bmpdata + (rawHeight < 0 ? y : height - 1 - y) * rowBytes;
+            for (int x = 0; x < width; x++) {
+                Color color;
+                memset(&color, 0, sizeof(Color));
+                uint8_t alpha = 255;
+                if (bitsPerPixel == 24) {
+                    color.b = row[x * 3];
+                    color.g = row[x * 3 + 1];
+                    color.r = row[x * 3 + 2];
+                } else {
+                    uint32_t value = *(uint32_t*)&row[x * 4];
+                    color.r = (value & redMask) >> maskShift(redMask);
+                    color.g = (value & greenMask) >> maskShift(greenMask);
+                    color.b = (value & blueMask) >> maskShift(blueMask);
+                    if (hasAlpha) {
+                        alpha = (value & alphaMask) >> maskShift(alphaMask);
+                    }
+                }
+
+                int i = y * width + x;
+                // 완전히 투명한 픽셀은 기존 방식대로 0(투명)으로 둡니다.
+                data[i] = alpha == 0 ? 0 : convertTo(color);
+                if (pixels != nullptr) {
+                    uint32_t r = (color.r * alpha + 127) / 255;
+                    uint32_t g = (color.g * alpha + 127) / 255;
+                    uint32_t b = (color.b * alpha + 127) / 255;
+                    pixels[i] = ((uint32_t)alpha << 24) | (r << 16) | (g << 8) | b;
+                }
+            }
+        }
+        return true;
+    }
+
+    ~Image() {
+        delete[] data;
+        delete[] pixels;
+    }
+};
+
+// 아틀라스(스프라이트 시트)의 이름 붙은 영역
+struct AtlasRegion {
+    char name[24];
+    int x, y, w, h;
+};
+
+// 그릴 원본 영역
+// pixels가 있으면 premultiplied ARGB로 블렌딩하고, 없으면 data를 0 투명색으로 복사합니다.
+struct SpriteView {
+    const FIXEL_FORMAT* data;
+    const uint32_t* pixels;
+    int stride;     // 한 행의 픽셀 수
+    int w, h;
+};
+
+// 하나의 이미지에 여러 스프라이트를 모아둔 텍스처
+// 설명 파일은 한 줄에 "이름 x y w h" 형식이며 '#'으로 시작하는 줄은 무시합니다.
+// 설명 파일이 없으면 이미지 전체를 "image"라는 영역 하나로 봅니다.
+class Atlas {
+private:
+    AtlasRegion regions[MAX_ATLAS_REGIONS];
+    int regionCount = 0;
+
+public:
+    Image * image = nullptr;
+
+    ~Atlas() {
+        delete image;
+    }
+
+    bool load(const char * imagePath, const char * descPath) {
+        return attach(new Image(imagePath), descPath);
+    }
+
+    // 이미 읽은 이미지(AssetLoader에서 받은 것 등)로 아틀라스를 만듭니다. 이미지는 아틀라스가 소유합니다.
+    bool attach(Image * loaded, const char * descPath) {
+        image = loaded;
+        if (image == nullptr || image->data == nullptr) {
+            return false;
+        }
+
+        FILE * desc = descPath != nullptr ? fopen(descPath, "r") : nullptr;
+        if (desc == nullptr) {
+            return addRegion("image", 0, 0, image->width, image->height) != -1;
+        }
+
+        char line[128];
+        while (fgets(line, sizeof(line), desc) != nullptr) {
+            char name[sizeof(AtlasRegion::name)];
+            int x, y, w, h;
+            if (line[0] == '#' || sscanf(line, "%23s %d %d %d %d", name, &x, &y, &w, &h) != 5) {
+                continue;
+            }
+            if (addRegion(name, x, y, w, h) == -1) {
+                std::cerr << "Error: invalid atlas region " << name << " in " << descPath << "." << std::endl;
+            }
+        }
+        fclose(desc);
+        return regionCount > 0;
+    }
+
+    // 같은 설명 파일을 쓰는 새 이미지로 바꿉니다 (플레이 중에 다시 읽은 시트 등).
+    // 영역이 새 이미지 밖으로 나가면 바꾸지 않고 새 이미지를 버립니다.
+    bool replace(Image * loaded) {
+        bool fits = loaded != nullptr && loaded->data != nullptr;
+        for (int i = 0; fits && i < regionCount; ++i) {
+            const AtlasRegion &r = regions[i];
+            fits = r.x + r.w <= loaded->width && r.y + r.h <= loaded->height;
+        }
+        if (!fits) {
+            delete loaded;
+            return false;
+        }
+        delete image;
+        image = loaded;
+        return true;
+    }
+
+    // 영역은 이미지 안에 있어야 합니다. 실패하면 -1
+    int addRegion(const char * name, int x, int y, int w, int h) {
+        if (regionCount >= MAX_ATLAS_REGIONS || x < 0 || y < 0 || w <= 0 || h <= 0 ||
+            x + w > image->width || y + h > image->height) {
+            return -1;
+        }
+        AtlasRegion &region = regions[regionCount];
+        snprintf(region.name, sizeof(region.name), "%s", name);
+        region.x = x;
+        region.y = y;
+        region.w = w;
+        region.h = h;
+        return regionCount++;
+    }
+
+    int find(const char * name) const {
+        for (int i = 0; i < regionCount; ++i) {
+            if (strcmp(regions[i].name, name) == 0) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    const AtlasRegion &region(int index) const { return regions[index]; }
+    int size() const { return regionCount; }
+
+    SpriteView view(int index) const {
+        const AtlasRegion &r = regions[index];
+        int offset = r.y * image->width + r.x;
+        return {image->data + offset, image->pixels != nullptr ? image->pixels + offset : nullptr,
+                image->width, r.w, r.h};
+    }
+};
+
+#include "engine/assets.h"
+
+// 아틀라스 영역 번호를 순서대로 돌려 쓰는 애니메이션
+struct Animation {
+    int regions[MAX_ANIMATION_FRAMES];
+    int count = 0;
+
+    // "prefix_0", "prefix_1" ... 영역을 찾아 순서대로 등록합니다.
+    // 하나도 없으면 아틀라스의 첫 영역만 씁니다.
+    void fromPrefix(const Atlas &atlas, const char * prefix) {
+        count = 0;
+        char name[sizeof(AtlasRegion::name)];
+        while (count < MAX_ANIMATION_FRAMES) {
+            snprintf(name, sizeof(name), "%s_%d", prefix, count);
+            int index = atlas.find(name);
+            if (index == -1) {
+                break;
+            }
+            regions[count++] = index;
+        }
+        if (count == 0) {
+            regions[count++] = 0;
+        }
+    }
+
+    int regionAt(int step) const {
+        return regions[((step % count) + count) % count];
+    }
+};
+
+// 색상 상수
+const Color SKY_BLUE = {135, 206, 235, 0};
+const Color BROWN = {139, 69, 19, 0};
+const Color RED = {255, 0, 0, 0};
+const Color DARK_GREEN = {0, 100, 0, 0};
+const Color DARK_GRAY = {169, 169, 169, 0};
+const Color DUST_COLOR = {222, 184, 135, 0};
+const Color HUD_COLOR = {255, 255, 255, 0};
+const Color DEBUG_BOX_COLOR = {255, 255, 0, 0};
+const Color DEBUG_VELOCITY_COLOR = {255, 0, 255, 0};
+
+const Color PLAYER_COLOR = RED;
+const Color BLOCK_COLOR = DARK_GRAY;
+
+
+
+
+// 고정소수점 (16.16)
+// 물리와 확대/회전 그리기에서 함께 씁니다.
+typedef int Fixed;
+const int FIXED_SHIFT = 16;
+const Fixed FIXED_ONE = 1 << FIXED_SHIFT;
+
+inline Fixed toFixed(int v) {
+    return v * FIXED_ONE;
+}
+
+// 내림 (음수도 아래쪽으로)
+inline int fixedToInt(Fixed v) {
+    return v >> FIXED_SHIFT;
+}
+
+inline Fixed fixedMul(Fixed a, Fixed b) {
+    return (Fixed)(((long long)a * b) >> FIXED_SHIFT);
+}
+
+// 클립 영역 [x0, x1) x [y0, y1)
+struct ClipRect {
+    int x0, y0, x1, y1;
+};
+
+// 클립 영역 스택
+// push는 현재 영역과의 교집합을 쌓으므로 안쪽 영역은 항상 바깥 영역 안에 있습니다.
+// 맨 아래는 항상 화면 전체입니다.
+class ClipStack {
+private:
+    ClipRect stack[MAX_CLIP_DEPTH];
+    int depth = 1;
+
+public:
+    ClipStack(int width = WIDTH, int height = HEIGHT) {
+        stack[0] = {0, 0, width, height};
+    }
+
+    bool push(int x, int y, int w, int h) {
+        if (depth >= MAX_CLIP_DEPTH) {
+            return false;
+        }
+        const ClipRect &top = stack[depth - 1];
+        ClipRect &rect = stack[depth++];
+        rect.x0 = std::max(x, top.x0);
+        rect.y0 = std::max(y, top.y0);
+        rect.x1 = std::max(rect.x0, std::min(x + w, top.x1));
+        rect.y1 = std::max(rect.y0, std::min(y + h, top.y1));
+        return true;
+    }
+
+    void pop() {
+        if (depth > 1) {
+            depth--;
+        }
+    }
+
+    const ClipRect &top() const { return stack[depth - 1]; }
+};
+
+// 사각형을 클립 영역으로 한 번 잘라냅니다. 잘린 만큼 소스 좌표(srcX, srcY)도 옮깁니다.
+// 그릴 것이 남지 않으면 false
+inline bool clipRect(const ClipRect &clip, int &x, int &y, int &w, int &h, int &srcX, int &srcY) {
+    int x0 = std::max(x, clip.x0), y0 = std::max(y, clip.y0);
+    int x1 = std::min(x + w, clip.x1), y1 = std::min(y + h, clip.y1);
+    if (x0 >= x1 || y0 >= y1) {
+        return false;
+    }
+    srcX += x0 - x;
+    srcY += y0 - y;
+    x = x0;
+    y = y0;
+    w = x1 - x0;
+    h = y1 - y0;
+    return true;
+}
+
+// 그리기 대상 (프레임버퍼나 메모리 버퍼)
+// 시작할 때 한 번 만들어 두고 모든 그리기 함수가 참조로 받습니다.
+// base는 xoffset/yoffset이 이미 반영된 (0, 0) 픽셀의 주소입니다.
+struct RenderTarget {
+    uint8_t* base;
+    int stride;         // 한 행의 바이트 수
+    int width, height;
+    int bitsPerPixel;
+    ClipStack clip;
+
+    FIXEL_FORMAT* row(int y) const {
+        return (FIXEL_FORMAT*)(base + (long)y * stride);
+    }
+};
+
+// fb_var_screeninfo/fb_fix_screeninfo 레이아웃의 메모리를 RenderTarget으로 만듭니다.
+// 프레임버퍼와 같은 레이아웃으로 잡은 백버퍼에도 그대로 씁니다.
+RenderTarget makeRenderTarget(uint8_t* ptr, const fb_var_screeninfo &vinfo, const fb_fix_screeninfo &finfo) {
+    RenderTarget target;
+    target.base = ptr + vinfo.xoffset * (vinfo.bits_per_pixel / 8) + (long)vinfo.yoffset * finfo.line_length;
+    target.stride = finfo.line_length;
+    target.width = vinfo.xres;
+    target.height = vinfo.yres;
+    target.bitsPerPixel = vinfo.bits_per_pixel;
+    target.clip = ClipStack(target.width, target.height);
+    return target;
+}
+
+// 메모리에 잡는 그리기 대상 (캐시된 레이어, UI 패널, 미리 그려둔 스프라이트 등)
+// 시작 주소와 각 행의 시작이 64바이트 경계에 맞춰져 있어 SIMD 커널에서 정렬된 접근을 쓸 수 있습니다.
+class Surface {
+private:
+    uint8_t* memory = nullptr;
+
+public:
+    int width, height;
+    int stride;         // 한 행의 바이트 수 (64의 배수)
+    int bitsPerPixel;
+
+    Surface(int w, int h) : width(w), height(h), bitsPerPixel(sizeof(FIXEL_FORMAT) * 8) {
+        stride = (int)((w * sizeof(FIXEL_FORMAT) + SURFACE_ALIGN - 1) & ~(SURFACE_ALIGN - 1));
+        memory = (uint8_t*)countedAlloc((size_t)stride * height, SURFACE_ALIGN);
+        if (memory == nullptr) {
+            std::cerr << "Error: cannot allocate " << w << "x" << h << " surface." << std::endl;
+            width = height = 0;
+            return;
+        }
+        memset(memory, 0, (size_t)stride * height);
+    }
+    ~Surface() {
+        countedFree(memory);
+    }
+    Surface(const Surface &) = delete;
+    Surface &operator=(const Surface &) = delete;
+
+    FIXEL_FORMAT* row(int y) const {
+        return (FIXEL_FORMAT*)(memory + (long)y * stride);
+    }
+
+    // 한 행의 픽셀 수 (blitRectData 등의 stride 인자)
+    int pitch() const {
+        return stride / (int)sizeof(FIXEL_FORMAT);
+    }
+
+    RenderTarget target() const {
+        RenderTarget target;
+        target.base = memory;
+        target.stride = stride;
+        target.width = width;
+        target.height = height;
+        target.bitsPerPixel = bitsPerPixel;
+        target.clip = ClipStack(width, height);
+        return target;
+    }
+};
+
+// 256색 팔레트 (화면 형식으로 미리 바꿔 둔 색)
+// wide는 AVX2 gather로 읽을 수 있도록 같은 색을 32비트로 넓혀 둔 사본입니다.
+struct Palette {
+    FIXEL_FORMAT colors[256];
+    uint32_t wide[256];
+
+    void set(int index, Color color) {
+        colors[index] = convertTo(color);
+        wide[index] = colors[index];
+    }
+
+    // [first, first + count) 구간을 한 칸씩 돌립니다 (팔레트 순환).
+    // 픽셀은 그대로 두고 색만 바뀌므로 물결/반짝임 같은 효과를 싸게 만들 수 있습니다.
+    void cycle(int first, int count) {
+        FIXEL_FORMAT last = colors[first + count - 1];
+        memmove(&colors[first + 1], &colors[first], (count - 1) * sizeof(FIXEL_FORMAT));
+        colors[first] = last;
+        for (int i = first; i < first + count; ++i) {
+            wide[i] = colors[i];
+        }
+    }
+};
+
+// 8비트 인덱스 색상 서피스
+// 픽셀마다 팔레트 번호 한 바이트만 저장하고, 그리거나 내보낼 때 팔레트로 펼칩니다.
+// 투명색 복사에서는 0번을 투명색으로 봅니다.
+class IndexedSurface {
+private:
+    uint8_t* memory = nullptr;
+
+public:
+    int width, height;
+    int stride;         // 한 행의 바이트 수 (64의 배수)
+    Palette palette;
+
+    IndexedSurface(int w, int h) : width(w), height(h) {
+        stride = (int)((w + SURFACE_ALIGN - 1) & ~(SURFACE_ALIGN - 1));
+        memory = (uint8_t*)countedAlloc((size_t)stride * height, SURFACE_ALIGN);
+        if (memory == nullptr) {
+            std::cerr << "Error: cannot allocate " << w << "x" << h << " indexed surface." << std::endl;
+            width = height = 0;
+            return;
+        }
+        memset(memory, 0, (size_t)stride * height);
+        memset(&palette, 0, sizeof(palette));
+    }
+    ~IndexedSurface() {
+        countedFree(memory);
+    }
+    IndexedSurface(const IndexedSurface &) = delete;
+    IndexedSurface &operator=(const IndexedSurface &) = delete;
+
+    uint8_t* row(int y) const {
+        return memory + (long)y * stride;
+    }
+
+    // 픽셀과 팔레트를 합친 크기
+    size_t bytes() const {
+        return (size_t)stride * height + sizeof(Palette);
+    }
+};
+
+// 한 행 채우기: 16바이트 경계까지는 한 픽셀씩, 그 다음부터는 정렬된 16바이트 저장
+// 짧은 행은 정렬을 맞추는 비용이 더 크므로 그냥 한 픽셀씩 씁니다.
+inline void fillRow(FIXEL_FORMAT* dst, FIXEL_FORMAT color, int count) {
+    int i = 0;
+    #if defined(__SSE2__)
+    if (count < 32) {
+        for (; i < count; ++i) {
+            dst[i] = color;
+        }
+        return;
+    }
+    while (i < count && ((uintptr_t)(dst + i) & 15) != 0) {
+        dst[i++] = color;
+    }
+    #if defined(USE_FIXEL_FORMAT_32)
+    const __m128i value = _mm_set1_epi32((int)color);
+    #else
+    const __m128i value = _mm_set1_epi16((short)color);
+    #endif
+    const int perVector = 16 / sizeof(FIXEL_FORMAT);
+    for (; i + perVector <= count; i += perVector) {
+        _mm_store_si128((__m128i*)(dst + i), value);
+    }
+    #endif
+    for (; i < count; ++i) {
+        dst[i] = color;
+    }
+}
+
+// 한 행 투명색 복사: 소스가 0인 픽셀만 대상 값을 남깁니다.
+void blitRow(FIXEL_FORMAT* dst, const FIXEL_FORMAT* src, int count) {
+    int i = 0;
+    #if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const int perVector = 16 / sizeof(FIXEL_FORMAT);
+    for (; i + perVector <= count; i += perVector) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        #if defined(USE_FIXEL_FORMAT_32)
+        __m128i transparent = _mm_cmpeq_epi32(s, zero);
+        #else
+        __m128i transparent = _mm_cmpeq_epi16(s, zero);
+        #endif
+        __m128i out = _mm_or_si128(_mm_and_si128(transparent, d), _mm_andnot_si128(transparent, s));
+        _mm_storeu_si128((__m128i*)(dst + i), out);
+    }
+    #endif
+    for (; i < count; ++i) {
+        if (src[i] != 0)
+            dst[i] = src[i];
+    }
+}
+
+void fillRect(RenderTarget &target, int x, int y, int w, int h, FIXEL_FORMAT color) {
+    int srcX = 0, srcY = 0;
+    if (color == 0 || !clipRect(target.clip.top(), x, y, w, h, srcX, srcY)) {
+        return;
+    }
+    for (int j = 0; j < h; ++j) {
+        fillRow(target.row(y + j) + x, color, w);
+    }
+}
+
+// 0을 투명색으로 보는 이미지 복사
+// stride는 소스 한 행의 픽셀 수 (아틀라스의 일부를 그릴 때는 아틀라스 전체 폭)
+void blitRectData(RenderTarget &target, int x, int y, int w, int h, const FIXEL_FORMAT * data, int stride) {
+    int srcX = 0, srcY = 0;
+    if (!clipRect(target.clip.top(), x, y, w, h, srcX, srcY)) {
+        return;
+    }
+    for (int j = 0; j < h; ++j) {
+        blitRow(target.row(y + j) + x, data + (srcY + j) * stride + srcX, w);
+    }
+}
+
+void fillRectData(RenderTarget &target, int x, int y, int w, int h, FIXEL_FORMAT * data) {
+    blitRectData(target, x, y, w, h, data, w);
+}
+
+// 투명색 없이 행 단위 memcpy로 복사
+void copyRectData(RenderTarget &target, int x, int y, int w, int h, const FIXEL_FORMAT * data, int stride) {
+    int srcX = 0, srcY = 0;
+    if (!clipRect(target.clip.top(), x, y, w, h, srcX, srcY)) {
+        return;
+    }
+    for (int j = 0; j < h; ++j) {
+        memcpy(target.row(y + j) + x, data + (srcY + j) * stride + srcX, w * sizeof(FIXEL_FORMAT));
+    }
+}
+
+// 대상 사이의 복사: src의 (sx, sy, w, h)를 dst의 (dx, dy)로
+// 소스 범위를 벗어나는 부분은 먼저 잘라내고, 나머지는 dst의 클립 영역으로 자릅니다.
+void copyRect(RenderTarget &dst, int dx, int dy, const RenderTarget &src, int sx, int sy, int w, int h) {
+    const ClipRect bounds = {0, 0, src.width, src.height};
+    int offsetX = 0, offsetY = 0;
+    if (!clipRect(bounds, sx, sy, w, h, offsetX, offsetY)) {
+        return;
+    }
+    copyRectData(dst, dx + offsetX, dy + offsetY, w, h, src.row(sy) + sx, src.stride / (int)sizeof(FIXEL_FORMAT));
+}
+
+// 0을 투명색으로 보는 서피스 전체 복사 (미리 그려둔 스프라이트용)
+void blitSurface(RenderTarget &dst, int x, int y, const Surface &src) {
+    blitRectData(dst, x, y, src.width, src.height, src.row(0), src.pitch());
+}
+
+#if defined(__SSE2__) && !defined(__AVX2__)
+// expandRow의 레지스터 하나(16바이트): 인덱스가 모두 같으면(uniform) 표를 한 번만 읽어 채우고,
+// 아니면 표에서 읽은 색을 레지스터에 모아 씁니다. transparent는 0번 인덱스 자리의 픽셀 마스크입니다.
+inline void expandVector(FIXEL_FORMAT* d, const uint8_t* s, bool uniform, __m128i transparent, const Palette &palette, bool keyed) {
+    const FIXEL_FORMAT* colors = palette.colors;
+    if (uniform) {
+        if (!keyed || s[0] != 0) {
+            #if defined(USE_FIXEL_FORMAT_32)
+            _mm_storeu_si128((__m128i*)d, _mm_set1_epi32((int)colors[s[0]]));
+            #else
+            _mm_storeu_si128((__m128i*)d, _mm_set1_epi16((short)colors[s[0]]));
+            #endif
+        }
+        return;
+    }
+    #if defined(USE_FIXEL_FORMAT_32)
+    __m128i out = _mm_setr_epi32((int)colors[s[0]], (int)colors[s[1]], (int)colors[s[2]], (int)colors[s[3]]);
+    #else
+    __m128i out = _mm_setr_epi16((short)colors[s[0]], (short)colors[s[1]], (short)colors[s[2]], (short)colors[s[3]],
+                                 (short)colors[s[4]], (short)colors[s[5]], (short)colors[s[6]], (short)colors[s[7]]);
+    #endif
+    if (keyed) {
+        out = _mm_or_si128(_mm_and_si128(transparent, _mm_loadu_si128((const __m128i*)d)), _mm_andnot_si128(transparent, out));
+    }
+    _mm_storeu_si128((__m128i*)d, out);
+}
+#endif
+
+// 팔레트 펼치기: 인덱스 한 바이트를 화면 형식 픽셀 하나로 바꿉니다.
+// 16개씩 보면서 같은 인덱스가 이어진 구간은 (배경의 가로 띠, 스프라이트의 단색 면과 투명한 가장자리)
+// 표를 한 번만 읽어 색 하나로 채우거나 건너뜁니다.
+// 섞인 구간은 AVX2이면 gather로, 아니면 표에서 읽은 색을 레지스터에 모아 16바이트씩 씁니다.
+// keyed이면 0번 인덱스 자리는 대상 픽셀을 그대로 둡니다. 섞인 구간은 분기 없이 마스크로 섞습니다.
+void expandRow(FIXEL_FORMAT* dst, const uint8_t* src, int count, const Palette &palette, bool keyed) {
+    int i = 0;
+    #if defined(__SSE2__)
+    const int perVector = 16 / sizeof(FIXEL_FORMAT);
+    for (; i + 16 <= count; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(src + i));
+        // 비트 j는 src[i + j]가 바로 앞 인덱스와 같은지 (0번 비트는 쓰지 않습니다)
+        int same = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_slli_si128(bytes, 1))) | 1;
+        if (same == 0xFFFF) {
+            if (!keyed || src[i] != 0) {
+                #if defined(USE_FIXEL_FORMAT_32)
+                const __m128i value = _mm_set1_epi32((int)palette.colors[src[i]]);
+                #else
+                const __m128i value = _mm_set1_epi16((short)palette.colors[src[i]]);
+                #endif
+                for (int k = 0; k < 16; k += perVector) {
+                    _mm_storeu_si128((__m128i*)(dst + i + k), value);
+                }
+            }
+            continue;
+        }
+        #if defined(__AVX2__)
+        const int* table = (const int*)palette.wide;
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i indexLo = _mm256_cvtepu8_epi32(bytes);
+        __m256i indexHi = _mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8));
+        __m256i lo = _mm256_i32gather_epi32(table, indexLo, 4);
+        __m256i hi = _mm256_i32gather_epi32(table, indexHi, 4);
+        #if defined(USE_FIXEL_FORMAT_32)
+        if (keyed) {
+            lo = _mm256_blendv_epi8(lo, _mm256_loadu_si256((const __m256i*)(dst + i)), _mm256_cmpeq_epi32(indexLo, zero));
+            hi = _mm256_blendv_epi8(hi, _mm256_loadu_si256((const __m256i*)(dst + i + 8)), _mm256_cmpeq_epi32(indexHi, zero));
+        }
+        _mm256_storeu_si256((__m256i*)(dst + i), lo);
+        _mm256_storeu_si256((__m256i*)(dst + i + 8), hi);
+        #else
+        // 32비트 16개를 16비트로 좁힙니다. packus는 128비트 단위로 섞이므로 순서를 되돌립니다.
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+        if (keyed) {
+            __m256i transparent = _mm256_cmpeq_epi16(_mm256_cvtepu8_epi16(bytes), zero);
+            packed = _mm256_blendv_epi8(packed, _mm256_loadu_si256((const __m256i*)(dst + i)), transparent);
+        }
+        _mm256_storeu_si256((__m256i*)(dst + i), packed);
+        #endif
+        #else
+        // 레지스터 하나(perVector 픽셀) 단위로 같은 인덱스만 있는지 보고 나눠 펼칩니다.
+        // keyed이면 인덱스 바이트의 0 마스크를 픽셀 폭으로 넓혀 넘깁니다.
+        __m128i transparent = _mm_cmpeq_epi8(bytes, _mm_setzero_si128());
+        __m128i lo = _mm_unpacklo_epi8(transparent, transparent);
+        __m128i hi = _mm_unpackhi_epi8(transparent, transparent);
+        #if defined(USE_FIXEL_FORMAT_32)
+        expandVector(dst + i, src + i, (same & 0xF) == 0xF, _mm_unpacklo_epi16(lo, lo), palette, keyed);
+        expandVector(dst + i + 4, src + i + 4, (((same >> 4) & 0xF) | 1) == 0xF, _mm_unpackhi_epi16(lo, lo), palette, keyed);
+        expandVector(dst + i + 8, src + i + 8, (((same >> 8) & 0xF) | 1) == 0xF, _mm_unpacklo_epi16(hi, hi), palette, keyed);
+        expandVector(dst + i + 12, src + i + 12, ((same >> 12) | 1) == 0xF, _mm_unpackhi_epi16(hi, hi), palette, keyed);
+        #else
+        expandVector(dst + i, src + i, (same & 0xFF) == 0xFF, lo, palette, keyed);
+        expandVector(dst + i + 8, src + i + 8, ((same >> 8) | 1) == 0xFF, hi, palette, keyed);
+        #endif
+        #endif
+    }
+    #endif
+    if (keyed) {
+        for (; i < count; ++i) {
+            if (src[i] != 0) {
+                dst[i] = palette.colors[src[i]];
+            }
+        }
+        return;
+    }
+    for (; i < count; ++i) {
+        dst[i] = palette.colors[src[i]];
+    }
+}
+
+// 인덱스 이미지의 (w, h) 영역을 펼쳐 그립니다. stride는 소스 한 행의 바이트 수
+void drawIndexedData(RenderTarget &target, int x, int y, int w, int h,
+                     const uint8_t* indices, int stride, const Palette &palette, bool keyed) {
+    int srcX = 0, srcY = 0;
+    if (!clipRect(target.clip.top(), x, y, w, h, srcX, srcY)) {
+        return;
+    }
+    for (int j = 0; j < h; ++j) {
+        expandRow(target.row(y + j) + x, indices + (long)(srcY + j) * stride + srcX, w, palette, keyed);
+    }
+}
+
+// 인덱스 서피스 전체를 펼쳐 그립니다.
+void drawIndexed(RenderTarget &target, int x, int y, const IndexedSurface &src, bool keyed) {
+    drawIndexedData(target, x, y, src.width, src.height, src.row(0), src.stride, src.palette, keyed);
+}
+
+// 알파 블렌딩 (premultiplied ARGB8888 소스)
+// out = src + dst * (255 - srcAlpha) / 255
+inline uint32_t div255(uint32_t x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+void blendRowScalar(FIXEL_FORMAT* dst, const uint32_t* src, int count) {
+    for (int i = 0; i < count; ++i) {
+        uint32_t s = src[i];
+        uint32_t ia = 255 - (s >> 24);
+        if (ia == 255) {
+            continue;
+        }
+        uint32_t sr = (s >> 16) & 0xFF, sg = (s >> 8) & 0xFF, sb = s & 0xFF;
+        #if defined(USE_FIXEL_FORMAT_32)
+        uint32_t d = dst[i];
+        uint32_t r = std::min(255u, sr + div255(((d >> 16) & 0xFF) * ia));
+        uint32_t g = std::min(255u, sg + div255(((d >> 8) & 0xFF) * ia));
+        uint32_t b = std::min(255u, sb + div255((d & 0xFF) * ia));
+        uint32_t a = std::min(255u, (s >> 24) + div255((d >> 24) * ia));
+        dst[i] = (a << 24) | (r << 16) | (g << 8) | b;
+        #else
+        uint32_t d = dst[i];
+        uint32_t dr = (d >> 11) & 31, dg = (d >> 5) & 63, db = d & 31;
+        uint32_t r = std::min(255u, sr + div255(((dr << 3) | (dr >> 2)) * ia));
+        uint32_t g = std::min(255u, sg + div255(((dg << 2) | (dg >> 4)) * ia));
+        uint32_t b = std::min(255u, sb + div255(((db << 3) | (db >> 2)) * ia));
+        dst[i] = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+        #endif
+    }
+}
+
+#if defined(__SSE2__)
+// 16비트 레인별 x * ia / 255
+inline __m128i mulDiv255Epi16(__m128i x, __m128i ia) {
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(x, ia), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+#endif
+
+void blendRow(FIXEL_FORMAT* dst, const uint32_t* src, int count) {
+    int i = 0;
+    #if defined(__SSE2__)
+    #if defined(USE_FIXEL_FORMAT_32)
+    // 4픽셀씩: 채널을 16비트로 풀어서 곱한 뒤 다시 묶고 포화 덧셈
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i full = _mm_set1_epi32(255);
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i ia = _mm_sub_epi32(full, _mm_srli_epi32(s, 24));
+        __m128i iaLo = _mm_unpacklo_epi32(ia, ia);
+        __m128i iaHi = _mm_unpackhi_epi32(ia, ia);
+        iaLo = _mm_or_si128(iaLo, _mm_slli_epi32(iaLo, 16));
+        iaHi = _mm_or_si128(iaHi, _mm_slli_epi32(iaHi, 16));
+        __m128i lo = mulDiv255Epi16(_mm_unpacklo_epi8(d, zero), iaLo);
+        __m128i hi = mulDiv255Epi16(_mm_unpackhi_epi8(d, zero), iaHi);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_adds_epu8(_mm_packus_epi16(lo, hi), s));
+    }
+    #else
+    // 8픽셀씩: ARGB 소스와 RGB565 대상을 8개의 16비트 레인으로 펼쳐서 계산
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    const __m128i full = _mm_set1_epi16(255);
+    for (; i + 8 <= count; i += 8) {
+        __m128i s0 = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i s1 = _mm_loadu_si128((const __m128i*)(src + i + 4));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+
+        __m128i sb = _mm_packs_epi32(_mm_and_si128(s0, byteMask), _mm_and_si128(s1, byteMask));
+        __m128i sg = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(s0, 8), byteMask), _mm_and_si128(_mm_srli_epi32(s1, 8), byteMask));
+        __m128i sr = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(s0, 16), byteMask), _mm_and_si128(_mm_srli_epi32(s1, 16), byteMask));
+        __m128i ia = _mm_sub_epi16(full, _mm_packs_epi32(_mm_srli_epi32(s0, 24), _mm_srli_epi32(s1, 24)));
+
+        __m128i dr = _mm_srli_epi16(d, 11);
+        __m128i dg = _mm_and_si128(_mm_srli_epi16(d, 5), _mm_set1_epi16(63));
+        __m128i db = _mm_and_si128(d, _mm_set1_epi16(31));
+        dr = _mm_or_si128(_mm_slli_epi16(dr, 3), _mm_srli_epi16(dr, 2));
+        dg = _mm_or_si128(_mm_slli_epi16(dg, 2), _mm_srli_epi16(dg, 4));
+        db = _mm_or_si128(_mm_slli_epi16(db, 3), _mm_srli_epi16(db, 2));
+
+        __m128i r = _mm_min_epi16(_mm_add_epi16(sr, mulDiv255Epi16(dr, ia)), full);
+        __m128i g = _mm_min_epi16(_mm_add_epi16(sg, mulDiv255Epi16(dg, ia)), full);
+        __m128i b = _mm_min_epi16(_mm_add_epi16(sb, mulDiv255Epi16(db, ia)), full);
+
+        __m128i out = _mm_slli_epi16(_mm_and_si128(r, _mm_set1_epi16(0xF8)), 8);
+        out = _mm_or_si128(out, _mm_slli_epi16(_mm_and_si128(g, _mm_set1_epi16(0xFC)), 3));
+        out = _mm_or_si128(out, _mm_srli_epi16(b, 3));
+        _mm_storeu_si128((__m128i*)(dst + i), out);
+    }
+    #endif
+    #endif
+    blendRowScalar(dst + i, src + i, count - i);
+}
+
+// 알파 이미지를 화면 범위로 한 번 잘라낸 뒤 행 단위로 블렌딩합니다.
+void blendRectData(RenderTarget &target, int x, int y, int w, int h, const uint32_t * pixels, int stride) {
+    int srcX = 0, srcY = 0;
+    if (!clipRect(target.clip.top(), x, y, w, h, srcX, srcY)) {
+        return;
+    }
+    for (int j = 0; j < h; ++j) {
+        blendRow(target.row(y + j) + x, pixels + (srcY + j) * stride + srcX, w);
+    }
+}
+
+// 고정소수점 DDA로 count 픽셀을 샘플링합니다 (최근접).
+// 원본 좌표는 (u, v)에서 시작해 픽셀마다 (du, dv)씩 움직입니다.
+// 범위는 호출하는 쪽에서 행마다 미리 잘라 두므로 여기서는 검사하지 않습니다.
+template <typename T>
+inline void sampleRow(T* out, const T* src, int stride, int count, Fixed u, Fixed v, Fixed du, Fixed dv) {
+    if (dv == 0) {
+        const T* row = src + fixedToInt(v) * stride;
+        for (int i = 0; i < count; ++i) {
+            out[i] = row[fixedToInt(u)];
+            u += du;
+        }
+        return;
+    }
+    for (int i = 0; i < count; ++i) {
+        out[i] = src[fixedToInt(v) * stride + fixedToInt(u)];
+        u += du;
+        v += dv;
+    }
+}
+
+// 샘플링한 픽셀을 조각 단위로 모아 기존 행 커널(blitRow/blendRow)로 씁니다.
+void sampleSpan(FIXEL_FORMAT* dst, const SpriteView &src, int count, Fixed u, Fixed v, Fixed du, Fixed dv) {
+    FIXEL_FORMAT keyed[SAMPLE_CHUNK];
+    uint32_t premultiplied[SAMPLE_CHUNK];
+    while (count > 0) {
+        int n = std::min(count, SAMPLE_CHUNK);
+        if (src.pixels != nullptr) {
+            sampleRow(premultiplied, src.pixels, src.stride, n, u, v, du, dv);
+            blendRow(dst, premultiplied, n);
+        } else {
+            sampleRow(keyed, src.data, src.stride, n, u, v, du, dv);
+            blitRow(dst, keyed, n);
+        }
+        dst += n;
+        count -= n;
+        u += du * n;
+        v += dv * n;
+    }
+}
+
+// 원본 전체를 (x, y, w, h)에 맞춰 늘리거나 줄여 그립니다.
+// 픽셀 중심에서 샘플링하므로 마지막 픽셀도 원본 안에 있습니다.
+void blitScaled(RenderTarget &target, int x, int y, int w, int h, const SpriteView &src) {
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+    const Fixed du = (Fixed)(((long long)src.w << FIXED_SHIFT) / w);
+    const Fixed dv = (Fixed)(((long long)src.h << FIXED_SHIFT) / h);
+    int offsetX = 0, offsetY = 0;
+    if (!clipRect(target.clip.top(), x, y, w, h, offsetX, offsetY)) {
+        return;
+    }
+    const Fixed u = du / 2 + offsetX * du;
+    for (int j = 0; j < h; ++j) {
+        Fixed v = dv / 2 + (offsetY + j) * dv;
+        sampleSpan(target.row(y + j) + x, src, w, u, v, du, 0);
+    }
+}
+
+// 스팬 래스터라이저
+// 선/원/다각형을 모두 가로 구간(스팬)으로 바꿔 fillRow로 채웁니다.
+// 클리핑은 스팬마다 한 번만 합니다.
+inline void fillSpan(RenderTarget &target, int x0, int x1, int y, FIXEL_FORMAT color) {
+    const ClipRect &clip = target.clip.top();
+    if (y < clip.y0 || y >= clip.y1) {
+        return;
+    }
+    x0 = std::max(x0, clip.x0);
+    x1 = std::min(x1, clip.x1);
+    if (x0 < x1) {
+        fillRow(target.row(y) + x0, color, x1 - x0);
+    }
+}
+
+// 브레젠험 직선 (양 끝점 포함)
+// 같은 행에 이어지는 픽셀은 한 스팬으로 모아서 채웁니다.
+void drawLine(RenderTarget &target, int x0, int y0, int x1, int y1, FIXEL_FORMAT color) {
+    const ClipRect &clip = target.clip.top();
+    if (color == 0 || std::max(x0, x1) < clip.x0 || std::min(x0, x1) >= clip.x1 ||
+        std::max(y0, y1) < clip.y0 || std::min(y0, y1) >= clip.y1) {
+        return;
+    }
+    int dx = abs(x1 - x0), dy = -abs(y1 - y0);
+    int sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    int runStart = x0;
+    while (true) {
+        if (x0 == x1 && y0 == y1) {
+            break;
+        }
+        int e2 = 2 * err;
+        bool stepY = e2 <= dx;
+        if (e2 >= dy) {
+            err += dy;
+            if (stepY) {
+                fillSpan(target, std::min(runStart, x0), std::max(runStart, x0) + 1, y0, color);
+            }
+            x0 += sx;
+        } else {
+            fillSpan(target, std::min(runStart, x0), std::max(runStart, x0) + 1, y0, color);
+        }
+        if (stepY) {
+            err += dx;
+            y0 += sy;
+            runStart = x0;
+        }
+    }
+    fillSpan(target, std::min(runStart, x0), std::max(runStart, x0) + 1, y0, color);
+}
+
+// 사각형 테두리 (안쪽 한 픽셀)
+void drawRectOutline(RenderTarget &target, int x, int y, int w, int h, FIXEL_FORMAT color) {
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+    fillRect(target, x, y, w, 1, color);
+    fillRect(target, x, y + h - 1, w, 1, color);
+    fillRect(target, x, y + 1, 1, h - 2, color);
+    fillRect(target, x + w - 1, y + 1, 1, h - 2, color);
+}
+
+// 중점 원 알고리즘
+// 한 팔분원을 따라가며 위/아래 행은 x가 늘어나는 구간을 모아 스팬 하나로, 옆 행은 점 하나로 채웁니다.
+void drawCircle(RenderTarget &target, int cx, int cy, int r, FIXEL_FORMAT color) {
+    if (color == 0 || r < 0) {
+        return;
+    }
+    int x = 0, y = r, d = 1 - r;
+    int runStart = 0;
+    while (x <= y) {
+        fillSpan(target, cx - y, cx - y + 1, cy - x, color);
+        fillSpan(target, cx + y, cx + y + 1, cy - x, color);
+        fillSpan(target, cx - y, cx - y + 1, cy + x, color);
+        fillSpan(target, cx + y, cx + y + 1, cy + x, color);
+        bool stepY = d >= 0;
+        d += stepY ? 2 * (x - y) + 5 : 2 * x + 3;
+        if (stepY || x + 1 > y) {
+            fillSpan(target, cx - x, cx - runStart + 1, cy - y, color);
+            fillSpan(target, cx + runStart, cx + x + 1, cy - y, color);
+            fillSpan(target, cx - x, cx - runStart + 1, cy + y, color);
+            fillSpan(target, cx + runStart, cx + x + 1, cy + y, color);
+            runStart = x + 1;
+        }
+        if (stepY) {
+            y--;
+        }
+        x++;
+    }
+}
+
+// 속이 찬 원: 중점 알고리즘이 지나는 행마다 양 끝 사이를 채웁니다.
+void fillCircle(RenderTarget &target, int cx, int cy, int r, FIXEL_FORMAT color) {
+    if (color == 0 || r < 0) {
+        return;
+    }
+    int x = 0, y = r, d = 1 - r;
+    while (x <= y) {
+        fillSpan(target, cx - y, cx + y + 1, cy - x, color);
+        if (x != 0) {
+            fillSpan(target, cx - y, cx + y + 1, cy + x, color);
+        }
+        if (d >= 0) {
+            // y가 바뀌기 직전에만 위/아래 행을 채웁니다.
+            if (x != y) {
+                fillSpan(target, cx - x, cx + x + 1, cy - y, color);
+                fillSpan(target, cx - x, cx + x + 1, cy + y, color);
+            }
+            d += 2 * (x - y) + 5;
+            y--;
+        } else {
+            d += 2 * x + 3;
+        }
+        x++;
+    }
+}
+
+struct Point {
+    int x, y;
+};
+
+// 스캔라인 다각형 채우기 (짝수-홀수 규칙이므로 오목한 다각형과 자기 교차도 됩니다)
+// 픽셀 중심 (x + 0.5, y + 0.5)이 안에 있는 픽셀만 채우므로 맞닿은 다각형끼리 겹치지 않습니다.
+void fillPolygon(RenderTarget &target, const Point* points, int count, FIXEL_FORMAT color) {
+    if (color == 0 || count < 3 || count > MAX_POLYGON_VERTICES) {
+        return;
+    }
+    int minY = points[0].y, maxY = points[0].y;
+    for (int i = 1; i < count; ++i) {
+        minY = std::min(minY, points[i].y);
+        maxY = std::max(maxY, points[i].y);
+    }
+    const ClipRect &clip = target.clip.top();
+    minY = std::max(minY, clip.y0);
+    maxY = std::min(maxY, clip.y1);
+
+    Fixed crossings[MAX_POLYGON_VERTICES];
+    for (int y = minY; y < maxY; ++y) {
+        // 이 행의 중심선과 만나는 변의 x (16.16)
+        const long long centerY2 = 2LL * y + 1;
+        int n = 0;
+        for (int i = 0; i < count; ++i) {
+            const Point &a = points[i];
+            const Point &b = points[(i + 1) % count];
+            if ((2LL * a.y <= centerY2) == (2LL * b.y <= centerY2)) {
+                continue;
+            }
+            long long t = (centerY2 - 2LL * a.y) * (b.x - a.x) * (FIXED_ONE / 2) / (b.y - a.y);
+            Fixed x = (Fixed)(((long long)a.x << FIXED_SHIFT) + t);
+            // 삽입 정렬 (교차점은 보통 두세 개)
+            int k = n++;
+            while (k > 0 && crossings[k - 1] > x) {
+                crossings[k] = crossings[k - 1];
+                k--;
+            }
+            crossings[k] = x;
+        }
+        for (int k = 0; k + 1 < n; k += 2) {
+            // ceil(x - 0.5): 중심이 교차점 오른쪽에 있는 첫 픽셀
+            int x0 = fixedToInt(crossings[k] + FIXED_ONE / 2 - 1);
+            int x1 = fixedToInt(crossings[k + 1] + FIXED_ONE / 2 - 1);
+            fillSpan(target, x0, x1, y, color);
+        }
+    }
+}
+
+// 화면 좌표 -> 원본 좌표 역변환 (16.16)
+// u = a * dx + b * dy, v = c * dx + d * dy  (dx, dy는 그리는 중심에서의 거리)
+struct AffineMap {
+    Fixed a, b;
+    Fixed c, d;
+};
+
+// 회전(라디안)한 뒤 가로/세로로 늘리는 변환의 역변환
+// 삼각함수는 만들 때 한 번만 계산하고, 그리는 동안은 정수 덧셈만 합니다.
+AffineMap makeAffine(float angle, float scaleX, float scaleY) {
+    float c = cosf(angle), s = sinf(angle);
+    return {(Fixed)(c / scaleX * FIXED_ONE), (Fixed)(s / scaleX * FIXED_ONE),
+            (Fixed)(-s / scaleY * FIXED_ONE), (Fixed)(c / scaleY * FIXED_ONE)};
+}
+
+inline long long floorDiv(long long n, long long d) {
+    long long q = n / d;
+    return (n % d != 0 && n < 0) ? q - 1 : q;
+}
+
+// base + step * x 가 [0, limit) 안에 드는 정수 x만 남도록 [x0, x1)을 좁힙니다.
+inline void clipSpan(long long base, long long step, long long limit, int &x0, int &x1) {
+    long long lo = x0, hi = x1;
+    if (step > 0) {
+        lo = std::max(lo, -floorDiv(base, step));
+        hi = std::min(hi, -floorDiv(base - limit, step));
+    } else if (step < 0) {
+        lo = std::max(lo, floorDiv(base - limit, -step) + 1);
+        hi = std::min(hi, floorDiv(base, -step) + 1);
+    } else if (base < 0 || base >= limit) {
+        hi = lo;
+    }
+    x0 = (int)lo;
+    x1 = (int)std::max(lo, hi);
+}
+
+// 원본의 중심을 화면의 (cx, cy)에 맞추고 역변환 m으로 회전/확대해 그립니다.
+// 행마다 원본 안에 드는 구간을 정확히 계산해 두므로 픽셀마다 범위를 검사하지 않습니다.
+void blitAffine(RenderTarget &target, int cx, int cy, const SpriteView &src, const AffineMap &m) {
+    // 원본 네 모서리를 화면으로 옮겨 그릴 범위를 구합니다.
+    double det = (double)m.a * m.d - (double)m.b * m.c;
+    if (det == 0.0) {
+        return;
+    }
+    double scale = (double)FIXED_ONE / det;
+    double minX = 0.0, maxX = 0.0, minY = 0.0, maxY = 0.0;
+    for (int k = 0; k < 4; ++k) {
+        double u = (k & 1 ? src.w : -src.w) * 0.5 * FIXED_ONE;
+        double v = (k & 2 ? src.h : -src.h) * 0.5 * FIXED_ONE;
+        double px = (m.d * u - m.b * v) * scale / FIXED_ONE;
+        double py = (-m.c * u + m.a * v) * scale / FIXED_ONE;
+        minX = std::min(minX, px);
+        maxX = std::max(maxX, px);
+        minY = std::min(minY, py);
+        maxY = std::max(maxY, py);
+    }
+    const ClipRect &clip = target.clip.top();
+    int y0 = std::max(clip.y0, cy + (int)floor(minY) - 1);
+    int y1 = std::min(clip.y1, cy + (int)ceil(maxY) + 1);
+    int spanX0 = std::max(clip.x0, cx + (int)floor(minX) - 1);
+    int spanX1 = std::min(clip.x1, cx + (int)ceil(maxX) + 1);
+
+    // 픽셀 중심 (x + 0.5, y + 0.5)에서 샘플링합니다.
+    const long long width = (long long)src.w << FIXED_SHIFT;
+    const long long height = (long long)src.h << FIXED_SHIFT;
+    for (int y = y0; y < y1; ++y) {
+        long long dy2 = 2LL * (y - cy) + 1;
+        long long baseU = (((long long)m.a * (1 - 2LL * cx) + m.b * dy2) >> 1) + width / 2;
+        long long baseV = (((long long)m.c * (1 - 2LL * cx) + m.d * dy2) >> 1) + height / 2;
+        int x0 = spanX0, x1 = spanX1;
+        clipSpan(baseU, m.a, width, x0, x1);
+        clipSpan(baseV, m.c, height, x0, x1);
+        if (x0 >= x1) {
+            continue;
+        }
+        sampleSpan(target.row(y) + x0, src, x1 - x0,
+                   (Fixed)(baseU + (long long)m.a * x0), (Fixed)(baseV + (long long)m.c * x0), m.a, m.c);
+    }
+}
+
+// 프레임버퍼로 내보내는 방식
+enum PresentMode {
+    PRESENT_COPY = 0,   // 일반 저장 (memcpy)
+    PRESENT_STREAM = 1, // non-temporal 저장 (캐시를 거치지 않고 write-combining 버퍼를 채움)
+    PRESENT_DELTA = 2,  // 지난 프레임과 비교하여 바뀐 구간만 씀 (SPI/USB 화면처럼 쓰기가 느린 경우)
+};
+
+// 한 행을 non-temporal 저장으로 복사합니다.
+// 대상 주소를 16(AVX는 32)바이트 경계에 맞춘 뒤 64바이트(캐시 라인 하나)씩 씁니다.
+// 저장 순서를 보장하려면 프레임을 다 내보낸 뒤 Presenter::endFrame()을 불러야 합니다.
+void streamRow(FIXEL_FORMAT* dst, const FIXEL_FORMAT* src, int count) {
+    int i = 0;
+    #if defined(__SSE2__)
+    if (count * (int)sizeof(FIXEL_FORMAT) < 128) {
+        memcpy(dst, src, count * sizeof(FIXEL_FORMAT));
+        return;
+    }
+    #if defined(__AVX__)
+    while (i < count && ((uintptr_t)(dst + i) & 31) != 0) {
+        dst[i] = src[i];
+        i++;
+    }
+    const int perVector = 32 / sizeof(FIXEL_FORMAT);
+    for (; i + perVector * 2 <= count; i += perVector * 2) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + i + perVector));
+        _mm256_stream_si256((__m256i*)(dst + i), a);
+        _mm256_stream_si256((__m256i*)(dst + i + perVector), b);
+    }
+    #else
+    while (i < count && ((uintptr_t)(dst + i) & 15) != 0) {
+        dst[i] = src[i];
+        i++;
+    }
+    const int perVector = 16 / sizeof(FIXEL_FORMAT);
+    for (; i + perVector * 4 <= count; i += perVector * 4) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + i + perVector));
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + i + perVector * 2));
+        __m128i d = _mm_loadu_si128((const __m128i*)(src + i + perVector * 3));
+        _mm_stream_si128((__m128i*)(dst + i), a);
+        _mm_stream_si128((__m128i*)(dst + i + perVector), b);
+        _mm_stream_si128((__m128i*)(dst + i + perVector * 2), c);
+        _mm_stream_si128((__m128i*)(dst + i + perVector * 3), d);
+    }
+    #endif
+    #endif
+    for (; i < count; ++i) {
+        dst[i] = src[i];
+    }
+}
+
+// 두 구간의 픽셀이 모두 같은지 16바이트씩 비교합니다.
+inline bool spanEqual(const FIXEL_FORMAT* a, const FIXEL_FORMAT* b, int count) {
+    int i = 0;
+    #if defined(__SSE2__)
+    const int perVector = 16 / sizeof(FIXEL_FORMAT);
+    for (; i + perVector <= count; i += perVector) {
+        __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(a + i)), _mm_loadu_si128((const __m128i*)(b + i)));
+        if (_mm_movemask_epi8(eq) != 0xFFFF) {
+            return false;
+        }
+    }
+    #endif
+    for (; i < count; ++i) {
+        if (a[i] != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 한 행을 가로로 factor배 늘립니다 (픽셀 복제).
+// 2배/4배는 SSE2 unpack으로 한 번에 16바이트씩 읽어 2(4)개의 벡터로 씁니다.
+void upscaleRow(FIXEL_FORMAT* dst, const FIXEL_FORMAT* src, int count, int factor) {
+    int i = 0;
+    #if defined(__SSE2__)
+    const int perVector = 16 / sizeof(FIXEL_FORMAT);
+    if (factor == 2) {
+        for (; i + perVector <= count; i += perVector) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+            #if defined(USE_FIXEL_FORMAT_32)
+            __m128i lo = _mm_unpacklo_epi32(v, v), hi = _mm_unpackhi_epi32(v, v);
+            #else
+            __m128i lo = _mm_unpacklo_epi16(v, v), hi = _mm_unpackhi_epi16(v, v);
+            #endif
+            _mm_storeu_si128((__m128i*)(dst + i * 2), lo);
+            _mm_storeu_si128((__m128i*)(dst + i * 2 + perVector), hi);
+        }
+    } else if (factor == 4) {
+        for (; i + perVector <= count; i += perVector) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+            #if defined(USE_FIXEL_FORMAT_32)
+            __m128i lo = _mm_unpacklo_epi32(v, v), hi = _mm_unpackhi_epi32(v, v);
+            __m128i a = _mm_unpacklo_epi64(lo, lo), b = _mm_unpackhi_epi64(lo, lo);
+            __m128i c = _mm_unpacklo_epi64(hi, hi), d = _mm_unpackhi_epi64(hi, hi);
+            #else
+            __m128i lo = _mm_unpacklo_epi16(v, v), hi = _mm_unpackhi_epi16(v, v);
+            __m128i a = _mm_unpacklo_epi32(lo, lo), b = _mm_unpackhi_epi32(lo, lo);
+            __m128i c = _mm_unpacklo_epi32(hi, hi), d = _mm_unpackhi_epi32(hi, hi);
+            #endif
+            FIXEL_FORMAT* out = dst + i * 4;
+            _mm_storeu_si128((__m128i*)out, a);
+            _mm_storeu_si128((__m128i*)(out + perVector), b);
+            _mm_storeu_si128((__m128i*)(out + perVector * 2), c);
+            _mm_storeu_si128((__m128i*)(out + perVector * 3), d);
+        }
+    }
+    #endif
+    for (; i < count; ++i) {
+        for (int k = 0; k < factor; ++k) {
+            dst[i * factor + k] = src[i];
+        }
+    }
+}
+
+// 프레임버퍼로 내보내는 창구
+// 내보내는 방식을 정하고, 실제로 프레임버퍼에 쓴 바이트 수를 셉니다.
+// scale이 1보다 크면 백버퍼의 한 행을 가로로 늘린 뒤 같은 행을 scale번 씁니다.
+// PRESENT_DELTA는 마지막으로 내보낸 프레임을 따로 가지고 있다가
+// 한 행을 DELTA_CHUNK_BYTES 단위로 비교하여 바뀐 덩어리가 이어진 구간만 씁니다.
+class Presenter {
+private:
+    Surface* previous = nullptr;
+    bool primed = false;    // 첫 프레임은 비교할 대상이 없으므로 모두 씁니다.
+    FIXEL_FORMAT* scaled = nullptr;     // 늘린 행 (화면 폭)
+    FIXEL_FORMAT* compose = nullptr;    // 오버레이 합성용 행 (화면 폭)
+
+    void write(RenderTarget &fb, int x, int y, const FIXEL_FORMAT* src, int count) {
+        if (mode == PRESENT_COPY) {
+            memcpy(fb.row(y) + x, src, count * sizeof(FIXEL_FORMAT));
+        } else {
+            streamRow(fb.row(y) + x, src, count);
+        }
+        frameBytes += (long)count * sizeof(FIXEL_FORMAT);
+    }
+
+public:
+    PresentMode mode;
+    long frameBytes = 0;    // 이번 프레임에 쓴 바이트 수
+    long lastFrameBytes = 0;
+    long maxFrameBytes = 0;
+    long totalBytes = 0;
+    long frames = 0;
+
+    int scale;
+
+    // 화면 크기는 프레임버퍼 크기, upscale은 내부 해상도에 대한 배율입니다.
+    Presenter(PresentMode mode, int screenWidth = WIDTH, int screenHeight = HEIGHT, int upscale = 1)
+        : mode(mode), scale(upscale) {
+        if (mode == PRESENT_DELTA) {
+            previous = new Surface(screenWidth, screenHeight);
+        }
+        size_t rowBytes = (screenWidth * sizeof(FIXEL_FORMAT) + SURFACE_ALIGN - 1) & ~(SURFACE_ALIGN - 1);
+        scaled = (FIXEL_FORMAT*)countedAlloc(rowBytes, SURFACE_ALIGN);
+        compose = (FIXEL_FORMAT*)countedAlloc(rowBytes, SURFACE_ALIGN);
+    }
+    ~Presenter() {
+        delete previous;
+        countedFree(scaled);
+        countedFree(compose);
+    }
+    Presenter(const Presenter &) = delete;
+    Presenter &operator=(const Presenter &) = delete;
+
+    // 한 행을 내보내기 전에 합성해 둘 임시 행
+    FIXEL_FORMAT* composeRow() const {
+        return compose;
+    }
+
+    // 백버퍼 좌표 (x, y)부터 count 픽셀을 내보냅니다. 범위는 호출하는 쪽에서 자릅니다.
+    void row(RenderTarget &fb, int x, int y, const FIXEL_FORMAT* src, int count) {
+        if (scale == 1) {
+            screenRow(fb, x, y, src, count);
+            return;
+        }
+        upscaleRow(scaled, src, count, scale);
+        for (int k = 0; k < scale; ++k) {
+            screenRow(fb, x * scale, y * scale + k, scaled, count * scale);
+        }
+    }
+
+    // 화면 좌표 (x, y)부터 count 픽셀을 내보냅니다.
+    void screenRow(RenderTarget &fb, int x, int y, const FIXEL_FORMAT* src, int count) {
+        if (previous == nullptr) {
+            write(fb, x, y, src, count);
+            return;
+        }
+        FIXEL_FORMAT* prev = previous->row(y);
+        if (!primed) {
+            write(fb, x, y, src, count);
+            memcpy(prev + x, src, count * sizeof(FIXEL_FORMAT));
+            return;
+        }
+        // 덩어리 경계는 행의 시작 기준으로 맞춥니다.
+        const int chunk = DELTA_CHUNK_BYTES / sizeof(FIXEL_FORMAT);
+        const int end = x + count;
+        int runStart = -1;
+        for (int start = x; start < end; ) {
+            int next = std::min((start / chunk + 1) * chunk, end);
+            bool same = spanEqual(prev + start, src + (start - x), next - start);
+            if (!same && runStart < 0) {
+                runStart = start;
+            } else if (same && runStart >= 0) {
+                write(fb, runStart, y, src + (runStart - x), start - runStart);
+                memcpy(prev + runStart, src + (runStart - x), (start - runStart) * sizeof(FIXEL_FORMAT));
+                runStart = -1;
+            }
+            start = next;
+        }
+        if (runStart >= 0) {
+            write(fb, runStart, y, src + (runStart - x), end - runStart);
+            memcpy(prev + runStart, src + (runStart - x), (end - runStart) * sizeof(FIXEL_FORMAT));
+        }
+    }
+
+    // 한 프레임을 다 내보낸 뒤 불러야 합니다. non-temporal 저장이 끝난 것을 보장하고 통계를 모읍니다.
+    void endFrame() {
+        #if defined(__SSE2__)
+        if (mode != PRESENT_COPY) {
+            _mm_sfence();
+        }
+        #endif
+        lastFrameBytes = frameBytes;
+        maxFrameBytes = std::max(maxFrameBytes, frameBytes);
+        totalBytes += frameBytes;
+        frames++;
+        frameBytes = 0;
+        primed = true;
+    }
+};
+
+// 화면 업데이트 함수
+// 화면에 내보내는 것은 클립 스택과 관계없이 화면 범위로만 자릅니다.
+void updateRect(RenderTarget &fb, const RenderTarget &buffer, int x, int y, int w, int h, Presenter &presenter) {
+    const ClipRect screen = {0, 0, std::min(fb.width / presenter.scale, buffer.width),
+                             std::min(fb.height / presenter.scale, buffer.height)};
+    int srcX = 0, srcY = 0;
+    if (!clipRect(screen, x, y, w, h, srcX, srcY)) {
+        return;
+    }
+    for (int j = 0; j < h; ++j) {
+        presenter.row(fb, x, y + j, buffer.row(y + j) + x, w);
+    }
+}
+
+void updateScreen(RenderTarget &fb, const RenderTarget &buffer, Presenter &presenter) {
+    updateRect(fb, buffer, 0, 0, buffer.width, buffer.height, presenter);
+}
+
+// 백버퍼에 반투명 오버레이를 합성하면서 화면 전체를 업데이트합니다.
+// 백버퍼는 건드리지 않고, 한 행씩 임시 버퍼에서 합성한 뒤 프레임버퍼로 복사합니다.
+void updateScreenWithOverlay(RenderTarget &fb, const RenderTarget &buffer, const Image &overlay, Presenter &presenter) {
+    FIXEL_FORMAT* row = presenter.composeRow();
+    int width = std::min(buffer.width, fb.width / presenter.scale);
+    int height = std::min(buffer.height, fb.height / presenter.scale);
+    int w = std::min(width, overlay.width);
+    for (int y = 0; y < height; ++y) {
+        memcpy(row, buffer.row(y), width * sizeof(FIXEL_FORMAT));
+        if (y < overlay.height) {
+            blendRow(row, overlay.pixels + y * overlay.width, w);
+        }
+        presenter.row(fb, 0, y, row, width);
+    }
+}
+
+// 인덱스 서피스를 한 행씩 팔레트로 펼치면서 바로 화면에 내보냅니다.
+// 백버퍼를 거치지 않으므로 메모리에서 읽는 양이 픽셀당 한 바이트입니다.
+// 게임(--palette)은 스프라이트를 백버퍼에서 배경 위에 합성하므로 이 경로로 내보낼 수 없고,
+// 펼친 행을 다시 행 버퍼에서 복사하는 만큼 백버퍼 복사보다 느립니다 (--bench indexed).
+// 인덱스 서피스는 메모리를 줄이는 선택이고, 게임에서는 팔레트를 돌린 프레임에만 펼칩니다.
+void updateScreenIndexed(RenderTarget &fb, const IndexedSurface &buffer, Presenter &presenter) {
+    FIXEL_FORMAT* row = presenter.composeRow();
+    int width = std::min(buffer.width, fb.width / presenter.scale);
+    int height = std::min(buffer.height, fb.height / presenter.scale);
+    for (int y = 0; y < height; ++y) {
+        expandRow(row, buffer.row(y), width, buffer.palette, false);
+        presenter.row(fb, 0, y, row, width);
+    }
+}
+
+// 가장자리로 갈수록 어두워지는 반투명 오버레이
+void makeVignetteOverlay(Image &overlay) {
+    const Color tint = {10, 10, 40, 0};
+    for (int y = 0; y < overlay.height; ++y) {
+        for (int x = 0; x < overlay.width; ++x) {
+            float dx = (x - overlay.width * 0.5f) / (overlay.width * 0.5f);
+            float dy = (y - overlay.height * 0.5f) / (overlay.height * 0.5f);
+            float d = (dx * dx + dy * dy) * 0.5f;
+            uint32_t alpha = (uint32_t)std::min(200.0f, 40.0f + 160.0f * d);
+            uint32_t r = (tint.r * alpha + 127) / 255;
+            uint32_t g = (tint.g * alpha + 127) / 255;
+            uint32_t b = (tint.b * alpha + 127) / 255;
+            overlay.pixels[y * overlay.width + x] = (alpha << 24) | (r << 16) | (g << 8) | b;
+        }
+    }
+}
+
+// 그리기 레이어 (작은 값부터 그립니다)
+enum DrawLayer {
+    LAYER_BACKGROUND = 0,
+    LAYER_WORLD = 1,
+    LAYER_PLAYER = 2,
+    LAYER_OVERLAY = 3,
+};
+
+enum DrawCommandType {
+    DRAW_FILL = 0,
+    DRAW_IMAGE = 1,
+    DRAW_BLEND = 2,
+    DRAW_COPY = 3,
+    DRAW_SCALED = 4,
+    DRAW_INDEXED = 5,
+    DRAW_INDEXED_KEYED = 6,
+};
+
+struct DrawCommand {
+    uint64_t sortKey;
+    DrawCommandType type;
+    int layer;
+    int x, y, w, h;
+    FIXEL_FORMAT color;
+    const FIXEL_FORMAT* data;
+    const uint32_t* pixels;
+    int stride;
+    int srcW, srcH;     // 늘려 그릴 때 원본 크기
+    const uint8_t* indices;
+    const Palette* palette;
+};
+
+// 프레임 단위 그리기 명령 목록
+// 각 시스템은 명령을 기록만 하고, 프레임 끝에서 레이어/위치 순으로 정렬한 뒤
+// 이어 붙일 수 있는 같은 색 사각형을 합쳐서 한 번에 실행합니다.
+// 같은 레이어 안의 명령끼리는 그리는 순서에 의존하지 않는다고 가정합니다.
+class DrawList {
+private:
+    DrawCommand* commands = nullptr;
+    int count = 0;
+    int capacity = 0;
+
+    // 정렬 키: 레이어 | 16픽셀 단위 행 | x | 기록 순서
+    // 기록 순서가 들어가므로 std::sort로도 결과가 항상 같습니다.
+    uint64_t makeKey(int layer, int x, int y) {
+        uint64_t band = (uint64_t)std::min(std::max(y + 32768, 0), 65535) >> 4;
+        uint64_t column = (uint64_t)std::min(std::max(x + 32768, 0), 65535);
+        return ((uint64_t)layer << 48) | (band << 32) | (column << 16) | (uint64_t)(count & 0xFFFF);
+    }
+
+    DrawCommand* push(DrawCommandType type, int layer, int x, int y, int w, int h) {
+        if (count >= capacity) {
+            dropped++;
+            return nullptr;
+        }
+        DrawCommand &cmd = commands[count];
+        cmd.sortKey = makeKey(layer, x, y);
+        cmd.type = type;
+        cmd.layer = layer;
+        cmd.x = x;
+        cmd.y = y;
+        cmd.w = w;
+        cmd.h = h;
+        cmd.color = 0;
+        cmd.data = nullptr;
+        cmd.pixels = nullptr;
+        cmd.stride = w;
+        cmd.srcW = w;
+        cmd.srcH = h;
+        cmd.indices = nullptr;
+        cmd.palette = nullptr;
+        count++;
+        recorded++;
+        return &cmd;
+    }
+
+public:
+    int recorded = 0;
+    int merged = 0;
+    int dropped = 0;
+
+    // 명령 저장 공간은 프레임 아레나에서 가져옵니다.
+    void begin(FrameArena &arena, int maxCommands) {
+        commands = arena.allocArray<DrawCommand>(maxCommands);
+        capacity = commands != nullptr ? maxCommands : 0;
+        count = 0;
+        recorded = 0;
+        merged = 0;
+        dropped = 0;
+    }
+
+    void fill(int layer, int x, int y, int w, int h, FIXEL_FORMAT color) {
+        DrawCommand* cmd = push(DRAW_FILL, layer, x, y, w, h);
+        if (cmd != nullptr) {
+            cmd->color = color;
+        }
+    }
+
+    void image(int layer, int x, int y, int w, int h, const FIXEL_FORMAT* data, int stride) {
+        DrawCommand* cmd = push(DRAW_IMAGE, layer, x, y, w, h);
+        if (cmd != nullptr) {
+            cmd->data = data;
+            cmd->stride = stride;
+        }
+    }
+
+    // premultiplied ARGB 이미지를 알파 블렌딩으로 그립니다.
+    void blend(int layer, int x, int y, int w, int h, const uint32_t* pixels, int stride) {
+        DrawCommand* cmd = push(DRAW_BLEND, layer, x, y, w, h);
+        if (cmd != nullptr) {
+            cmd->pixels = pixels;
+            cmd->stride = stride;
+        }
+    }
+
+    // 서피스의 일부를 투명색 없이 그대로 복사합니다. (캐시된 배경 레이어 복원 등)
+    void copy(int layer, int x, int y, int w, int h, const Surface &src, int sx, int sy) {
+        const ClipRect bounds = {0, 0, src.width, src.height};
+        int offsetX = 0, offsetY = 0;
+        if (!clipRect(bounds, sx, sy, w, h, offsetX, offsetY)) {
+            return;
+        }
+        DrawCommand* cmd = push(DRAW_COPY, layer, x + offsetX, y + offsetY, w, h);
+        if (cmd != nullptr) {
+            cmd->data = src.row(sy) + sx;
+            cmd->stride = src.pitch();
+        }
+    }
+
+    // 아틀라스의 한 영역을 그립니다. 알파가 있으면 블렌딩, 없으면 0 투명색 복사.
+    void sprite(int layer, int x, int y, const Atlas &atlas, int regionIndex) {
+        const AtlasRegion &region = atlas.region(regionIndex);
+        const Image &image = *atlas.image;
+        int offset = region.y * image.width + region.x;
+        if (image.pixels != nullptr) {
+            blend(layer, x, y, region.w, region.h, image.pixels + offset, image.width);
+        } else {
+            this->image(layer, x, y, region.w, region.h, image.data + offset, image.width);
+        }
+    }
+
+    // 인덱스 서피스의 일부를 팔레트로 펼쳐 그립니다. 팔레트는 실행할 때 읽습니다.
+    void indexed(int layer, int x, int y, int w, int h, const IndexedSurface &src, int sx, int sy, bool keyed) {
+        const ClipRect bounds = {0, 0, src.width, src.height};
+        int offsetX = 0, offsetY = 0;
+        if (!clipRect(bounds, sx, sy, w, h, offsetX, offsetY)) {
+            return;
+        }
+        DrawCommand* cmd = push(keyed ? DRAW_INDEXED_KEYED : DRAW_INDEXED, layer, x + offsetX, y + offsetY, w, h);
+        if (cmd != nullptr) {
+            cmd->indices = src.row(sy) + sx;
+            cmd->stride = src.stride;
+            cmd->palette = &src.palette;
+        }
+    }
+
+    // 아틀라스의 한 영역을 (x, y, w, h)에 맞춰 늘리거나 줄여 그립니다.
+    void spriteScaled(int layer, int x, int y, int w, int h, const Atlas &atlas, int regionIndex) {
+        const SpriteView src = atlas.view(regionIndex);
+        DrawCommand* cmd = push(DRAW_SCALED, layer, x, y, w, h);
+        if (cmd != nullptr) {
+            cmd->data = src.data;
+            cmd->pixels = src.pixels;
+            cmd->stride = src.stride;
+            cmd->srcW = src.w;
+            cmd->srcH = src.h;
+        }
+    }
+
+    // 정렬 후 바로 옆에 붙어 있는 같은 색 사각형을 하나로 합칩니다.
+    void sortAndMerge() {
+        std::sort(commands, commands + count, [](const DrawCommand &a, const DrawCommand &b) {
+            return a.sortKey < b.sortKey;
+        });
+
+        int out = 0;
+        for (int i = 0; i < count; ++i) {
+            DrawCommand &cmd = commands[i];
+            if (out > 0) {
+                DrawCommand &prev = commands[out - 1];
+                if (prev.type == DRAW_FILL && cmd.type == DRAW_FILL &&
+                    prev.layer == cmd.layer && prev.color == cmd.color) {
+                    if (prev.y == cmd.y && prev.h == cmd.h && prev.x + prev.w == cmd.x) {
+                        prev.w += cmd.w;
+                        merged++;
+                        continue;
+                    }
+                    if (prev.x == cmd.x && prev.w == cmd.w && prev.y + prev.h == cmd.y) {
+                        prev.h += cmd.h;
+                        merged++;
+                        continue;
+                    }
+                }
+            }
+            commands[out++] = cmd;
+        }
+        count = out;
+    }
+
+    // 화면의 [bandY0, bandY1) 행을 클립 영역으로 잡고 명령을 실행합니다.
+    void executeBand(RenderTarget &target, int bandY0, int bandY1) {
+        target.clip.push(0, bandY0, target.width, bandY1 - bandY0);
+        for (int i = 0; i < count; ++i) {
+            const DrawCommand &cmd = commands[i];
+            if (cmd.y >= bandY1 || cmd.y + cmd.h <= bandY0) {
+                continue;
+            }
+            if (cmd.type == DRAW_FILL) {
+                fillRect(target, cmd.x, cmd.y, cmd.w, cmd.h, cmd.color);
+            } else if (cmd.type == DRAW_IMAGE) {
+                blitRectData(target, cmd.x, cmd.y, cmd.w, cmd.h, cmd.data, cmd.stride);
+            } else if (cmd.type == DRAW_COPY) {
+                copyRectData(target, cmd.x, cmd.y, cmd.w, cmd.h, cmd.data, cmd.stride);
+            } else if (cmd.type == DRAW_SCALED) {
+                const SpriteView src = {cmd.data, cmd.pixels, cmd.stride, cmd.srcW, cmd.srcH};
+                blitScaled(target, cmd.x, cmd.y, cmd.w, cmd.h, src);
+            } else if (cmd.type == DRAW_INDEXED || cmd.type == DRAW_INDEXED_KEYED) {
+                drawIndexedData(target, cmd.x, cmd.y, cmd.w, cmd.h, cmd.indices, cmd.stride, *cmd.palette,
+                                cmd.type == DRAW_INDEXED_KEYED);
+            } else {
+                blendRectData(target, cmd.x, cmd.y, cmd.w, cmd.h, cmd.pixels, cmd.stride);
+            }
+        }
+        target.clip.pop();
+    }
+
+    // 화면을 가로 띠로 나누어 작업 스레드에 분배합니다.
+    // 띠끼리는 겹치지 않으므로 스레드 수와 관계없이 결과가 같습니다.
+    // 밴드마다 대상을 복사해서 각자의 클립 스택을 씁니다.
+    void execute(const RenderTarget &target, WorkerPool &workers) {
+        int bands = workers.size() == 1 ? 1 : workers.size() * 4;
+        int bandHeight = (target.height + bands - 1) / bands;
+        auto task = [&](int band) {
+            RenderTarget bandTarget = target;
+            executeBand(bandTarget, band * bandHeight, std::min((band + 1) * bandHeight, target.height));
+        };
+        workers.parallelFor(bands, task);
+    }
+
+    int size() const { return count; }
+};
+
+// 5x7 비트맵 글꼴 (' ' ~ 'Z')
+// 글자마다 다섯 열이고, 각 바이트의 비트 0이 맨 윗줄입니다.
+const int FONT_FIRST_CHAR = ' ';
+const int FONT_LAST_CHAR = 'Z';
+const int FONT_GLYPH_WIDTH = 5;
+const int FONT_GLYPH_HEIGHT = 7;
+const uint8_t FONT_5X7[FONT_LAST_CHAR - FONT_FIRST_CHAR + 1][FONT_GLYPH_WIDTH] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00}, // ' ' ! "
+    {0x14, 0x7F, 0x14, 0x7F, 0x14}, {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62}, // # $ %
+    {0x36, 0x49, 0x55, 0x22, 0x50}, {0x00, 0x05, 0x03, 0x00, 0x00}, {0x00, 0x1C, 0x22, 0x41, 0x00}, // & ' (
+    {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x14, 0x08, 0x3E, 0x08, 0x14}, {0x08, 0x08, 0x3E, 0x08, 0x08}, // ) * +
+    {0x00, 0x50, 0x30, 0x00, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x60, 0x60, 0x00, 0x00}, // , - .
+    {0x20, 0x10, 0x08, 0x04, 0x02}, {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00}, // / 0 1
+    {0x42, 0x61, 0x51, 0x49, 0x46}, {0x21, 0x41, 0x45, 0x4B, 0x31}, {0x18, 0x14, 0x12, 0x7F, 0x10}, // 2 3 4
+    {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x30}, {0x01, 0x71, 0x09, 0x05, 0x03}, // 5 6 7
+    {0x36, 0x49, 0x49, 0x49, 0x36}, {0x06, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x36, 0x36, 0x00, 0x00}, // 8 9 :
+    {0x00, 0x56, 0x36, 0x00, 0x00}, {0x08, 0x14, 0x22, 0x41, 0x00}, {0x14, 0x14, 0x14, 0x14, 0x14}, // ; < =
+    {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x51, 0x09, 0x06}, {0x32, 0x49, 0x79, 0x41, 0x3E}, // > ? @
+    {0x7E, 0x11, 0x11, 0x11, 0x7E}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22}, // A B C
+    {0x7F, 0x41, 0x41, 0x22, 0x1C}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x09, 0x01}, // D E F
+    {0x3E, 0x41, 0x49, 0x49, 0x7A}, {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00}, // G H I
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41}, {0x7F, 0x40, 0x40, 0x40, 0x40}, // J K L
+    {0x7F, 0x02, 0x0C, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E}, // M N O
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46}, // P Q R
+    {0x46, 0x49, 0x49, 0x49, 0x31}, {0x01, 0x01, 0x7F, 0x01, 0x01}, {0x3F, 0x40, 0x40, 0x40, 0x3F}, // S T U
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x3F, 0x40, 0x38, 0x40, 0x3F}, {0x63, 0x14, 0x08, 0x14, 0x63}, // V W X
+    {0x07, 0x08, 0x70, 0x08, 0x07}, {0x61, 0x51, 0x49, 0x45, 0x43},                                 // Y Z
+};
+
+// 비트맵 글꼴
+// 시작할 때 모든 글자를 한 번 FIXEL_FORMAT 이미지 한 장으로 바꿔 둡니다 (배경은 0 = 투명).
+// 소문자는 대문자로, 없는 글자는 '?'로 그립니다. 색이 0(검정)이면 보이지 않습니다.
+class BitmapFont {
+private:
+    FIXEL_FORMAT* glyphs = nullptr;
+
+    static int glyphIndex(char c) {
+        if (c >= 'a' && c <= 'z') {
+            c = c - 'a' + 'A';
+        }
+        if (c < FONT_FIRST_CHAR || c > FONT_LAST_CHAR) {
+            c = '?';
+        }
+        return c - FONT_FIRST_CHAR;
+    }
+
+public:
+    int scale;
+    int advance;    // 글자 사이 한 칸을 포함한 폭
+    int height;
+    int stride;     // 글자를 가로로 이어 붙인 이미지의 한 행 픽셀 수
+
+    BitmapFont(FIXEL_FORMAT color, int glyphScale = 1) : scale(glyphScale) {
+        const int glyphCount = FONT_LAST_CHAR - FONT_FIRST_CHAR + 1;
+        advance = (FONT_GLYPH_WIDTH + 1) * scale;
+        height = FONT_GLYPH_HEIGHT * scale;
+        stride = glyphCount * advance;
+        glyphs = new FIXEL_FORMAT[stride * height]();
+        for (int g = 0; g < glyphCount; ++g) {
+            for (int column = 0; column < FONT_GLYPH_WIDTH; ++column) {
+                for (int line = 0; line < FONT_GLYPH_HEIGHT; ++line) {
+                    if ((FONT_5X7[g][column] >> line) & 1) {
+                        for (int j = 0; j < scale; ++j) {
+                            FIXEL_FORMAT* row = glyphs + (line * scale + j) * stride + g * advance + column * scale;
+                            for (int k = 0; k < scale; ++k) {
+                                row[k] = color;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    ~BitmapFont() {
+        delete[] glyphs;
+    }
+    BitmapFont(const BitmapFont &) = delete;
+    BitmapFont &operator=(const BitmapFont &) = delete;
+
+    // 글자 이미지의 왼쪽 위 (폭 advance, 높이 height, stride)
+    const FIXEL_FORMAT* glyph(char c) const {
+        return glyphs + glyphIndex(c) * advance;
+    }
+
+    int textWidth(const char * text) const {
+        return (int)strlen(text) * advance;
+    }
+
+    // 캐시 없이 글자마다 하나씩 그립니다.
+    void draw(RenderTarget &target, int x, int y, const char * text) const {
+        for (; *text != '\0'; ++text, x += advance) {
+            blitRectData(target, x, y, advance, height, glyph(*text), stride);
+        }
+    }
+};
+
+// 문자열 단위 캐시
+// 한 번 그린 문자열은 한 줄짜리 이미지로 남겨 두고, 다음부터는 글자를 다시 조립하지 않고 한 번에 blit 합니다.
+// 슬롯은 시작할 때 모두 잡아 두고 가장 오래 쓰지 않은 것부터 바꿉니다.
+// DrawList에 넘긴 이미지는 실행될 때까지 살아 있어야 하므로 한 프레임에 TEXT_CACHE_RUNS개 넘게 쓰면 안 됩니다.
+class TextCache {
+public:
+    struct Run {
+        char text[TEXT_RUN_MAX_CHARS + 1];
+        uint32_t hash;
+        int width;
+        uint32_t lastUsed;
+        FIXEL_FORMAT* pixels;
+    };
+
+private:
+    const BitmapFont &font;
+    Run runs[TEXT_CACHE_RUNS];
+    FIXEL_FORMAT* storage = nullptr;
+    uint32_t clock = 0;
+
+public:
+    int stride;     // 캐시 이미지의 한 행 픽셀 수
+    long hits = 0;
+    long misses = 0;
+
+    TextCache(const BitmapFont &textFont) : font(textFont) {
+        stride = TEXT_RUN_MAX_CHARS * font.advance;
+        storage = new FIXEL_FORMAT[TEXT_CACHE_RUNS * stride * font.height];
+        for (int i = 0; i < TEXT_CACHE_RUNS; ++i) {
+            runs[i].text[0] = '\0';
+            runs[i].hash = 0;
+            runs[i].width = 0;
+            runs[i].lastUsed = 0;
+            runs[i].pixels = storage + i * stride * font.height;
+        }
+    }
+    ~TextCache() {
+        delete[] storage;
+    }
+    TextCache(const TextCache &) = delete;
+    TextCache &operator=(const TextCache &) = delete;
+
+    // 문자열의 이미지를 찾고, 없으면 가장 오래된 슬롯에 새로 그립니다. 긴 문자열은 잘립니다.
+    const Run &get(const char * text) {
+        uint32_t hash = 2166136261u;
+        int length = 0;
+        for (; text[length] != '\0' && length < TEXT_RUN_MAX_CHARS; ++length) {
+            hash = (hash ^ (uint8_t)text[length]) * 16777619u;
+        }
+        clock++;
+
+        Run* oldest = &runs[0];
+        for (Run &run : runs) {
+            if (run.hash == hash && run.width == length * font.advance &&
+                strncmp(run.text, text, length) == 0 && run.text[length] == '\0') {
+                run.lastUsed = clock;
+                hits++;
+                return run;
+            }
+            if (run.lastUsed < oldest->lastUsed) {
+                oldest = &run;
+            }
+        }
+
+        Run &run = *oldest;
+        memcpy(run.text, text, length);
+        run.text[length] = '\0';
+        run.hash = hash;
+        run.width = length * font.advance;
+        run.lastUsed = clock;
+        for (int j = 0; j < font.height; ++j) {
+            FIXEL_FORMAT* row = run.pixels + j * stride;
+            for (int i = 0; i < length; ++i) {
+                memcpy(row + i * font.advance, font.glyph(text[i]) + j * font.stride, font.advance * sizeof(FIXEL_FORMAT));
+            }
+        }
+        misses++;
+        return run;
+    }
+
+    void draw(DrawList &drawList, int layer, int x, int y, const char * text) {
+        const Run &run = get(text);
+        drawList.image(layer, x, y, run.width, font.height, run.pixels, stride);
+    }
+
+    void draw(RenderTarget &target, int x, int y, const char * text) {
+        const Run &run = get(text);
+        blitRectData(target, x, y, run.width, font.height, run.pixels, stride);
+    }
+};
+
+// 프레임 체크섬 (FNV-1a, 화면에 보이는 영역만)
+uint32_t frameChecksum(const RenderTarget &buffer) {
+    uint32_t hash = 2166136261u;
+    for (int y = 0; y < buffer.height; ++y) {
+        const uint8_t* row = (const uint8_t*)buffer.row(y);
+        for (int i = 0; i < buffer.width * (int)sizeof(FIXEL_FORMAT); ++i) {
+            hash = (hash ^ row[i]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+// 리플레이 파일 포맷
+// [ReplayHeader][ReplayRecord ...]
+// 입력 이벤트는 발생한 프레임 번호를 타임스탬프로 기록하고,
+// 매 프레임 끝에는 REPLAY_FRAME_END 레코드에 그 프레임의 체크섬을 남깁니다.
+// 헤더에는 체크섬에 영향을 주는 실행 설정(화면 크기, 배율, 틱 주기, 그리기 옵션)도 남깁니다.
+const char REPLAY_MAGIC[4] = {'F', 'B', 'R', 'P'};
+const uint16_t REPLAY_VERSION = 2;
+const uint16_t REPLAY_FRAME_END = 0xFFFF;
+
+// ReplaySettings::flags
+const uint32_t REPLAY_OVERLAY = 1;
+const uint32_t REPLAY_HUD = 2;
+const uint32_t REPLAY_DEBUG = 4;
+const uint32_t REPLAY_PALETTE = 8;
+
+struct ReplaySettings {
+    uint16_t screenWidth, screenHeight;
+    uint16_t upscale;
+    uint16_t simHz;
+    uint32_t flags;
+};
+
+struct ReplayHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t pixelBits;
+    uint32_t frameCount;
+    ReplaySettings settings;
+};
+
+struct ReplayRecord {
+    uint32_t frame;
+    uint16_t type;
+    uint16_t code;
+    int value;
+};
+
+class InputRecorder {
+private:
+    FILE * file = nullptr;
+    ReplayHeader header;
+
+public:
+    bool open(const char * path) {
+        file = fopen(path, "wb");
+        if (file == nullptr) {
+            std::cerr << "Error: cannot open replay file " << path << "." << std::endl;
+            return false;
+        }
+        memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+        header.version = REPLAY_VERSION;
+        header.pixelBits = sizeof(FIXEL_FORMAT) * 8;
+        header.frameCount = 0;
+        memset(&header.settings, 0, sizeof(header.settings));
+        fwrite(&header, sizeof(header), 1, file);
+        return true;
+    }
+
+    // 화면과 배율이 정해진 뒤에 부릅니다. 헤더는 녹화가 끝날 때 다시 씁니다.
+    void describe(const ReplaySettings &settings) {
+        header.settings = settings;
+    }
+
+    void event(uint32_t frame, const input_event &ev) {
+        ReplayRecord record = {frame, ev.type, ev.code, ev.value};
+        fwrite(&record, sizeof(record), 1, file);
+    }
+
+    void frameEnd(uint32_t frame, uint32_t checksum) {
+        ReplayRecord record = {frame, REPLAY_FRAME_END, 0, (int)checksum};
+        fwrite(&record, sizeof(record), 1, file);
+        header.frameCount = frame + 1;
+    }
+
+    ~InputRecorder() {
+        if (file == nullptr) {
+            return;
+        }
+        // 녹화가 끝나면 총 프레임 수를 헤더에 다시 씁니다.
+        fseek(file, 0, SEEK_SET);
+        fwrite(&header, sizeof(header), 1, file);
+        fclose(file);
+    }
+};
+
+class InputReplayer {
+private:
+    std::vector<ReplayRecord> records;
+    size_t cursor = 0;
+
+public:
+    uint32_t frameCount = 0;
+    ReplaySettings settings;
+    int mismatches = 0;
+    int desyncs = 0;        // 프레임 번호가 어긋나 건너뛴 레코드와 빠진 프레임 끝 레코드 수
+
+    bool open(const char * path) {
+        FILE * file = fopen(path, "rb");
+        if (file == nullptr) {
+            std::cerr << "Error: cannot open replay file " << path << "." << std::endl;
+            return false;
+        }
+
+        ReplayHeader header;
+        if (fread(&header, sizeof(header), 1, file) != 1 ||
+            memcmp(header.magic, REPLAY_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != REPLAY_VERSION) {
+            std::cerr << "Error: invalid replay file " << path << "." << std::endl;
+            fclose(file);
+            return false;
+        }
+        if (header.pixelBits != sizeof(FIXEL_FORMAT) * 8) {
+            std::cerr << "Warning: replay was recorded with " << header.pixelBits << "bpp, checksums will not match." << std::endl;
+        }
+
+        ReplayRecord record;
+        while (fread(&record, sizeof(record), 1, file) == 1) {
+            records.push_back(record);
+        }
+        fclose(file);
+
+        frameCount = header.frameCount;
+        settings = header.settings;
+        return true;
+    }
+
+    // 지난 프레임의 레코드가 남아 있으면 (레코드가 빠졌거나 순서가 어긋난 파일) 건너뛰어 프레임 번호를 다시 맞춥니다.
+    // 그대로 두면 커서가 그 레코드에 멈춰 이후 입력이 하나도 적용되지 않습니다.
+    void resync(uint32_t frame) {
+        while (cursor < records.size() && records[cursor].frame < frame) {
+            if (desyncs == 0) {
+                printf("replay: record for frame %u is out of step at frame %u, resynchronising\n",
+                       records[cursor].frame, frame);
+            }
+            desyncs++;
+            cursor++;
+        }
+    }
+
+    // 현재 프레임에 기록된 다음 입력 이벤트를 꺼냅니다.
+    bool nextEvent(uint32_t frame, input_event &ev) {
+        resync(frame);
+        if (cursor >= records.size() || records[cursor].frame != frame || records[cursor].type == REPLAY_FRAME_END) {
+            return false;
+        }
+        memset(&ev, 0, sizeof(ev));
+        ev.type = records[cursor].type;
+        ev.code = records[cursor].code;
+        ev.value = records[cursor].value;
+        cursor++;
+        return true;
+    }
+
+    // 프레임 끝 레코드와 체크섬을 비교합니다.
+    void frameEnd(uint32_t frame, uint32_t checksum) {
+        resync(frame);
+        if (cursor >= records.size() || records[cursor].type != REPLAY_FRAME_END || records[cursor].frame != frame) {
+            if (desyncs == 0) {
+                printf("replay: frame end record missing at frame %u\n", frame);
+            }
+            desyncs++;
+            return;
+        }
+        if ((uint32_t)records[cursor].value != checksum) {
+            if (mismatches == 0) {
+                printf("replay: first checksum mismatch at frame %u (expected %08x, got %08x)\n",
+                       frame, (uint32_t)records[cursor].value, checksum);
+            }
+            mismatches++;
+        }
+        cursor++;
+    }
+
+    // 헤더의 프레임 수보다 먼저 레코드가 끝나면 (잘린 파일) 입력 없이 계속 돌리지 않고 멈춥니다.
+    bool finished(uint32_t frame) {
+        if (frame < frameCount && cursor >= records.size()) {
+            printf("replay: file ends at frame %u of %u, stopping\n", frame, frameCount);
+            desyncs++;
+            return true;
+        }
+        return frame >= frameCount;
+    }
+};
+
+#include "engine/frame_ring.h"
+
+// 스냅샷에 들어가는 파티클 (ParticleSystem::save/restore)
+// ParticleSystem과 같은 SoA 배열이라 배열마다 살아 있는 만큼 memcpy 한 번으로 옮깁니다.
+struct SnapshotParticles {
+    int32_t count;
+    uint32_t seed;      // 파티클 난수 상태
+    float x[MAX_PARTICLES], y[MAX_PARTICLES];
+    float vx[MAX_PARTICLES], vy[MAX_PARTICLES];
+    float life[MAX_PARTICLES];
+    FIXEL_FORMAT color[MAX_PARTICLES];
+};
+
+// 파티클 시스템
+// 위치/속도/남은 수명을 SoA 배열로 따로 두어 4개씩 SIMD로 갱신합니다.
+// 파티클이 많으면 계산보다 배열을 읽고 쓰는 메모리 대역폭이 한계이므로, 갱신과 죽은 파티클 제거를 한 번에 훑습니다.
+// 죽은 파티클은 뒤의 것을 앞으로 당겨 빼므로 순서가 유지되고 결과는 결정적입니다.
+class ParticleSystem {
+private:
+    float* px = nullptr;
+    float* py = nullptr;
+    float* vx = nullptr;
+    float* vy = nullptr;
+    float* life = nullptr;
+    FIXEL_FORMAT* color = nullptr;
+    int capacity = 0;
+    int count = 0;
+    uint32_t seed = 1;
+
+    static float* allocFloats(int n) {
+        float* array = (float*)countedAlloc(n * sizeof(float), 16);
+        memset(array, 0, n * sizeof(float));
+        return array;
+    }
+
+    // [0, 1) 난수 (리플레이에서 같은 결과가 나오도록 자체 LCG 사용)
+    float random() {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) * (1.0f / 16777216.0f);
+    }
+
+public:
+    float gravity = 0.25f;  // 틱당 속도 증가 (픽셀)
+    ClipRect bounds = {0, 0, 0, 0};    // 마지막 render에서 그린 영역 (비어 있으면 x0 >= x1)
+
+    ParticleSystem(int maxParticles) {
+        capacity = (maxParticles + 3) & ~3;
+        px = allocFloats(capacity);
+        py = allocFloats(capacity);
+        vx = allocFloats(capacity);
+        vy = allocFloats(capacity);
+        life = allocFloats(capacity);
+        color = (FIXEL_FORMAT*)countedAlloc(((capacity * sizeof(FIXEL_FORMAT) + 15) & ~15), 16);
+    }
+    ~ParticleSystem() {
+        countedFree(px);
+        countedFree(py);
+        countedFree(vx);
+        countedFree(vy);
+        countedFree(life);
+        countedFree(color);
+    }
+    ParticleSystem(const ParticleSystem &) = delete;
+    ParticleSystem &operator=(const ParticleSystem &) = delete;
+
+    int size() const { return count; }
+
+    // 살아 있는 파티클과 난수 상태를 out에 적습니다. MAX_PARTICLES개를 넘으면 적지 않고 false
+    bool save(SnapshotParticles &out) const {
+        if (count > MAX_PARTICLES) {
+            return false;
+        }
+        out.count = count;
+        out.seed = seed;
+        memcpy(out.x, px, count * sizeof(float));
+        memcpy(out.y, py, count * sizeof(float));
+        memcpy(out.vx, vx, count * sizeof(float));
+        memcpy(out.vy, vy, count * sizeof(float));
+        memcpy(out.life, life, count * sizeof(float));
+        memcpy(out.color, color, count * sizeof(FIXEL_FORMAT));
+        return true;
+    }
+
+    // 이 시스템에 다 들어가지 않으면 바꾸지 않고 false
+    bool restore(const SnapshotParticles &in) {
+        if (in.count < 0 || in.count > capacity) {
+            return false;
+        }
+        count = in.count;
+        seed = in.seed;
+        memcpy(px, in.x, count * sizeof(float));
+        memcpy(py, in.y, count * sizeof(float));
+        memcpy(vx, in.vx, count * sizeof(float));
+        memcpy(vy, in.vy, count * sizeof(float));
+        memcpy(life, in.life, count * sizeof(float));
+        memcpy(color, in.color, count * sizeof(FIXEL_FORMAT));
+        return true;
+    }
+
+    // (x, y)에서 위쪽 반원으로 흩어지는 파티클을 n개 만듭니다. 가득 차면 남는 것은 버립니다.
+    void emit(float x, float y, int n, float speed, float lifetime, FIXEL_FORMAT c) {
+        n = std::min(n, capacity - count);
+        for (int k = 0; k < n; ++k) {
+            int i = count++;
+            px[i] = x;
+            py[i] = y;
+            vx[i] = (random() * 2.0f - 1.0f) * speed;
+            vy[i] = -random() * speed;
+            life[i] = lifetime * (0.5f + random() * 0.5f);
+            color[i] = c;
+        }
+    }
+
+    // 한 틱 진행: 중력, 이동, 수명 감소, 죽은 파티클 제거
+    void update() {
+        int out = 0, i = 0;
+        #if defined(__SSE2__)
+        const __m128 g = _mm_set1_ps(gravity);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 zero = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4) {
+            __m128 velocityX = _mm_load_ps(vx + i);
+            __m128 velocityY = _mm_add_ps(_mm_load_ps(vy + i), g);
+            __m128 x = _mm_add_ps(_mm_load_ps(px + i), velocityX);
+            __m128 y = _mm_add_ps(_mm_load_ps(py + i), velocityY);
+            __m128 remaining = _mm_sub_ps(_mm_load_ps(life + i), one);
+            int alive = _mm_movemask_ps(_mm_cmpgt_ps(remaining, zero));
+            if (alive == 15 && out == i) {
+                // 아직 아무것도 죽지 않았으면 제자리에 씁니다 (대부분의 묶음).
+                _mm_store_ps(px + i, x);
+                _mm_store_ps(py + i, y);
+                _mm_store_ps(vy + i, velocityY);
+                _mm_store_ps(life + i, remaining);
+                out += 4;
+                continue;
+            }
+            if (alive == 15) {
+                _mm_storeu_ps(px + out, x);
+                _mm_storeu_ps(py + out, y);
+                _mm_storeu_ps(vx + out, velocityX);
+                _mm_storeu_ps(vy + out, velocityY);
+                _mm_storeu_ps(life + out, remaining);
+                for (int k = 0; k < 4; ++k) {
+                    color[out + k] = color[i + k];
+                }
+                out += 4;
+                continue;
+            }
+            alignas(16) float xs[4], ys[4], vxs[4], vys[4], lives[4];
+            _mm_store_ps(xs, x);
+            _mm_store_ps(ys, y);
+            _mm_store_ps(vxs, velocityX);
+            _mm_store_ps(vys, velocityY);
+            _mm_store_ps(lives, remaining);
+            for (int k = 0; k < 4; ++k) {
+                if (alive & (1 << k)) {
+                    px[out] = xs[k];
+                    py[out] = ys[k];
+                    vx[out] = vxs[k];
+                    vy[out] = vys[k];
+                    life[out] = lives[k];
+                    color[out] = color[i + k];
+                    out++;
+                }
+            }
+        }
+        #endif
+        count = updateRange(i, out);
+    }
+
+    // SIMD를 쓰지 않는 같은 계산 (비교용)
+    void updateScalar() {
+        count = updateRange(0, 0);
+    }
+
+    // [from, count)를 하나씩 진행해 out부터 채우고 새 개수를 돌려줍니다.
+    int updateRange(int from, int out) {
+        for (int i = from; i < count; ++i) {
+            float velocityY = vy[i] + gravity;
+            float remaining = life[i] - 1.0f;
+            if (!(remaining > 0.0f)) {
+                continue;
+            }
+            px[out] = px[i] + vx[i];
+            py[out] = py[i] + velocityY;
+            vx[out] = vx[i];
+            vy[out] = velocityY;
+            life[out] = remaining;
+            color[out] = color[i];
+            out++;
+        }
+        return out;
+    }
+
+    // 같은 파티클을 같은 순서로 갖고 있는지 비교합니다 (--bench particles 확인용).
+    bool same(const ParticleSystem &other) const {
+        return count == other.count && memcmp(px, other.px, count * sizeof(float)) == 0 &&
+               memcmp(py, other.py, count * sizeof(float)) == 0 && memcmp(vx, other.vx, count * sizeof(float)) == 0 &&
+               memcmp(vy, other.vy, count * sizeof(float)) == 0 && memcmp(life, other.life, count * sizeof(float)) == 0 &&
+               memcmp(color, other.color, count * sizeof(FIXEL_FORMAT)) == 0;
+    }
+
+    // size x size 점으로 찍습니다. 좌표 변환, 클립 판정, 그린 영역 계산은 4개씩 SIMD로 하고 통과한 것만 씁니다.
+    // 점 찍기는 화면 곳곳에 흩어진 쓰기라 비용의 대부분이므로 한 점마다 하는 일을 주소 계산과 저장으로 줄입니다.
+    void render(RenderTarget &target, int size) {
+        const ClipRect &clip = target.clip.top();
+        const int maxX = clip.x1 - size, maxY = clip.y1 - size;
+        int minDrawnX = clip.x1, minDrawnY = clip.y1, maxDrawnX = clip.x0 - 1, maxDrawnY = clip.y0 - 1;
+        uint8_t* const base = target.base;
+        const long stride = target.stride;
+        auto splat = [&](int i, int x, int y) {
+            FIXEL_FORMAT* row = (FIXEL_FORMAT*)(base + y * stride) + x;
+            FIXEL_FORMAT c = color[i];
+            for (int j = 0; j < size; ++j) {
+                for (int k = 0; k < size; ++k) {
+                    row[k] = c;
+                }
+                row = (FIXEL_FORMAT*)((uint8_t*)row + stride);
+            }
+        };
+
+        int i = 0;
+        #if defined(__SSE2__)
+        const __m128i loX = _mm_set1_epi32(clip.x0 - 1), hiX = _mm_set1_epi32(maxX + 1);
+        const __m128i loY = _mm_set1_epi32(clip.y0 - 1), hiY = _mm_set1_epi32(maxY + 1);
+        // 그린 영역은 통과한 레인만 min/max에 들어가도록 나머지 레인을 반대쪽 끝 값으로 바꿔 모읍니다.
+        const __m128 far = _mm_set1_ps(1.0e9f), near = _mm_set1_ps(-1.0e9f);
+        __m128 minXs = far, minYs = far, maxXs = near, maxYs = near;
+        alignas(16) int xs[4], ys[4];
+        for (; i + 4 <= count; i += 4) {
+            __m128i x = _mm_cvttps_epi32(_mm_load_ps(px + i));
+            __m128i y = _mm_cvttps_epi32(_mm_load_ps(py + i));
+            __m128i inside = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(x, loX), _mm_cmplt_epi32(x, hiX)),
+                                           _mm_and_si128(_mm_cmpgt_epi32(y, loY), _mm_cmplt_epi32(y, hiY)));
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(inside));
+            if (mask == 0) {
+                continue;
+            }
+            __m128 keep = _mm_castsi128_ps(inside);
+            __m128 fx = _mm_cvtepi32_ps(x), fy = _mm_cvtepi32_ps(y);
+            minXs = _mm_min_ps(minXs, _mm_or_ps(_mm_and_ps(keep, fx), _mm_andnot_ps(keep, far)));
+            minYs = _mm_min_ps(minYs, _mm_or_ps(_mm_and_ps(keep, fy), _mm_andnot_ps(keep, far)));
+            maxXs = _mm_max_ps(maxXs, _mm_or_ps(_mm_and_ps(keep, fx), _mm_andnot_ps(keep, near)));
+            maxYs = _mm_max_ps(maxYs, _mm_or_ps(_mm_and_ps(keep, fy), _mm_andnot_ps(keep, near)));
+            _mm_store_si128((__m128i*)xs, x);
+            _mm_store_si128((__m128i*)ys, y);
+            if (size == 1) {
+                while (mask != 0) {
+                    int k = __builtin_ctz(mask);
+                    mask &= mask - 1;
+                    ((FIXEL_FORMAT*)(base + ys[k] * stride))[xs[k]] = color[i + k];
+                }
+            } else {
+                while (mask != 0) {
+                    int k = __builtin_ctz(mask);
+                    mask &= mask - 1;
+                    splat(i + k, xs[k], ys[k]);
+                }
+            }
+        }
+        alignas(16) float lo[4], hi[4];
+        _mm_store_ps(lo, _mm_min_ps(minXs, _mm_shuffle_ps(minXs, minXs, _MM_SHUFFLE(1, 0, 3, 2))));
+        _mm_store_ps(hi, _mm_max_ps(maxXs, _mm_shuffle_ps(maxXs, maxXs, _MM_SHUFFLE(1, 0, 3, 2))));
+        minDrawnX = std::min(minDrawnX, (int)std::min(lo[0], lo[1]));
+        maxDrawnX = std::max(maxDrawnX, (int)std::max(hi[0], hi[1]));
+        _mm_store_ps(lo, _mm_min_ps(minYs, _mm_shuffle_ps(minYs, minYs, _MM_SHUFFLE(1, 0, 3, 2))));
+        _mm_store_ps(hi, _mm_max_ps(maxYs, _mm_shuffle_ps(maxYs, maxYs, _MM_SHUFFLE(1, 0, 3, 2))));
+        minDrawnY = std::min(minDrawnY, (int)std::min(lo[0], lo[1]));
+        maxDrawnY = std::max(maxDrawnY, (int)std::max(hi[0], hi[1]));
+        #endif
+        for (; i < count; ++i) {
+            // 정수로 바꿀 수 없는 값은 SIMD 경로처럼 버립니다.
+            if (!(px[i] > -2.0e9f && px[i] < 2.0e9f && py[i] > -2.0e9f && py[i] < 2.0e9f)) {
+                continue;
+            }
+            int x = (int)px[i], y = (int)py[i];
+            if (x >= clip.x0 && x <= maxX && y >= clip.y0 && y <= maxY) {
+                splat(i, x, y);
+                minDrawnX = std::min(minDrawnX, x);
+                maxDrawnX = std::max(maxDrawnX, x);
+                minDrawnY = std::min(minDrawnY, y);
+                maxDrawnY = std::max(maxDrawnY, y);
+            }
+        }
+
+        if (maxDrawnX < minDrawnX) {
+            bounds = {0, 0, 0, 0};
+        } else {
+            bounds = {minDrawnX, minDrawnY, maxDrawnX + size, maxDrawnY + size};
+        }
+    }
+};
+
+// 프레임버퍼로 복사할 영역
+struct DirtyRect {
+    int x, y, w, h;
+};
+
+#include "engine/physics.h"
+
+// 유닛 클래스
+class Unit {
+protected:
+    int x, y;
+
+public:
+    Unit(int startX, int startY) : x(startX), y(startY) {}
+
+    virtual void draw(DrawList &drawList) = 0;
+
+    virtual void move(int dx) {
+        x += dx;
+    }
+
+    virtual void setY(int targetY) {
+        y = targetY;
+    }
+
+    int getX() const { return x; }
+    int getY() const { return y; }
+};
+
+// 플레이어 클래스
+class Player : public Unit {
+private:
+    Atlas * atlas;
+    Animation animation;
+
+public:
+    int width = 20;
+    int height = 20;
+    Body body;
+    int squash = 0;     // 찌그러진 채로 남은 프레임 수
+    DirtyRect drawn;    // 마지막으로 그린 영역 (찌그러진 크기 포함)
+
+    // 아틀라스는 여러 인스턴스가 공유하므로 소유하지 않습니다.
+    Player(int startX, int startY, Atlas * playerAtlas, const Animation &playerAnimation)
+        : Unit(startX, startY), atlas(playerAtlas), animation(playerAnimation) {
+        const AtlasRegion &region = atlas->region(animation.regionAt(0));
+        width = region.w;
+        height = region.h;
+        y -= height;
+        body = {toFixed(x), toFixed(y), toFixed(width), toFixed(height), 0, 0};
+        drawn = {x, y, width, height};
+    }
+
+    // 위에 떨어져 튀어 오를 때 잠깐 납작해집니다.
+    void land() {
+        squash = SQUASH_FRAMES;
+    }
+
+    // 물리 상태를 그리기 좌표에 반영합니다.
+    void syncFromBody() {
+        x = fixedToInt(body.x);
+        y = fixedToInt(body.y);
+    }
+
+    // 공이 굴러가는 것처럼 보이도록 이동한 거리에 따라 프레임을 고릅니다.
+    // 찌그러지는 동안은 바닥 가운데를 기준으로 넓고 낮게 늘려 그립니다.
+    void draw(DrawList &drawList) override {
+        int step = x >= 0 ? x / ROLL_PIXELS_PER_FRAME : (x - ROLL_PIXELS_PER_FRAME + 1) / ROLL_PIXELS_PER_FRAME;
+        int region = animation.regionAt(step);
+        if (squash > 0) {
+            int amount = SQUASH_PERCENT * squash / SQUASH_FRAMES;
+            int w = width + width * amount / 100;
+            int h = height - height * amount / 100;
+            drawn = {x - (w - width) / 2, y + height - h, w, h};
+            drawList.spriteScaled(LAYER_PLAYER, drawn.x, drawn.y, w, h, *atlas, region);
+            squash--;
+        } else {
+            drawn = {x, y, width, height};
+            drawList.sprite(LAYER_PLAYER, x, y, *atlas, region);
+        }
+    }
+
+    // 지나간 자리는 미리 그려둔 배경 레이어에서 복원합니다.
+    void remove(DrawList &drawList, const Surface &background) {
+        drawList.copy(LAYER_BACKGROUND, drawn.x, drawn.y, drawn.w, drawn.h, background, drawn.x, drawn.y);
+    }
+
+};
+
+class Block: public Unit {
+private:
+
+public:
+    int width, height;
+    Block(int startX, int startY, int w, int h) : Unit(startX, startY), width(w), height(h) {}
+
+    void draw(DrawList &drawList) override {
+        FIXEL_FORMAT blockColor = convertTo(BLOCK_COLOR);
+        drawList.fill(LAYER_WORLD, x, y, width, height, blockColor);
+    }
+
+    Box box() const {
+        return {toFixed(x), toFixed(y), toFixed(width), toFixed(height)};
+    }
+};
+
+// 땅은 좌우로 끝없이 이어진 상자로 다룹니다.
+Box groundBox() {
+    return {-(1 << 30), toFixed(GROUND_LEVEL), 0x7FFFFFFF, toFixed(HEIGHT)};
+}
+
+// 기본 레벨의 i번째 블록 위치
+void levelBlockPosition(int i, int &x, int &y) {
+    x = layoutX(130 + i * 100);
+    y = HEIGHT - layoutY(80 + 20 * i);
+}
+
+// 땅과 기본 레벨 블록을 상자 배열로 만듭니다. 상자 수를 돌려줍니다.
+int makeLevelBoxes(Box * boxes) {
+    int count = 0;
+    boxes[count++] = groundBox();
+    for (int i = 0; i < LEVEL_BLOCKS; ++i) {
+        int x, y;
+        levelBlockPosition(i, x, y);
+        boxes[count++] = {toFixed(x), toFixed(y), toFixed(LEVEL_BLOCK_WIDTH), toFixed(LEVEL_BLOCK_HEIGHT)};
+    }
+    return count;
+}
+
+// 월드 스냅샷
+// 시뮬레이션 상태 전체를 포인터 없는 고정 크기 구조체 하나에 담아 memcpy 한 번으로 저장/복원합니다.
+// 파일에는 구조체를 그대로 쓰므로 헤더의 버전, 크기, 화면 크기, 틱 주기가 맞아야 읽을 수 있습니다.
+// 들어가지 않는 것:
+//   - 화면 쪽 상태 (player.drawn, particles.bounds 등): 복원한 뒤에도 지금 화면에 그려진 것을 지워야 합니다.
+//   - 키 상태: 복원한 뒤에도 지금 눌린 키를 따라야 합니다.
+// 먼지 파티클은 MAX_PARTICLES개까지 모두 저장합니다. 더 많으면 잘라 내지 않고 저장이 실패합니다.
+const char SNAPSHOT_MAGIC[4] = {'F', 'B', 'S', 'S'};
+const uint16_t SNAPSHOT_VERSION = 2;
+// 되감기 버퍼 길이 (프레임)
+const int REWIND_FRAMES = 5 * 60;
+
+struct BlockState {
+    int32_t x, y, w, h;
+};
+
+struct Snapshot {
+    char magic[4];
+    uint16_t version;
+    uint16_t pixelBits;     // 파티클 색의 픽셀 형식
+    uint32_t size;          // sizeof(Snapshot)
+    int32_t width, height;  // 배치 좌표가 내부 해상도를 따르므로 같아야 합니다.
+    int32_t simHz;
+    uint32_t frame;
+    Fixed simTime;
+    Body player;
+    int32_t squash;
+    int32_t blockCount;
+    BlockState blocks[MAX_BLOCKS];
+    SnapshotParticles particles;
+};
+static_assert(std::is_trivially_copyable<Snapshot>::value, "Snapshot must stay plain data");
+
+// 파티클이 스냅샷에 다 들어가지 않으면 false
+bool saveSnapshot(Snapshot &snapshot, uint32_t frame, int simHz, Fixed simTime, const Player &player,
+                  Pool<Block, MAX_BLOCKS> &blocks, const ParticleSystem &particles) {
+    memcpy(snapshot.magic, SNAPSHOT_MAGIC, sizeof(snapshot.magic));
+    snapshot.version = SNAPSHOT_VERSION;
+    snapshot.pixelBits = sizeof(FIXEL_FORMAT) * 8;
+    snapshot.size = sizeof(Snapshot);
+    snapshot.width = WIDTH;
+    snapshot.height = HEIGHT;
+    snapshot.simHz = simHz;
+    snapshot.frame = frame;
+    snapshot.simTime = simTime;
+    snapshot.player = player.body;
+    snapshot.squash = player.squash;
+    snapshot.blockCount = 0;
+    blocks.forEach([&](Block &block) {
+        snapshot.blocks[snapshot.blockCount++] = {block.getX(), block.getY(), block.width, block.height};
+    });
+    if (!particles.save(snapshot.particles)) {
+        std::cerr << "Error: " << particles.size() << " particles do not fit in a snapshot (max " << MAX_PARTICLES << ")." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 이 실행에서 쓸 수 있는 스냅샷인지 확인합니다.
+bool validSnapshot(const Snapshot &snapshot, int simHz) {
+    return memcmp(snapshot.magic, SNAPSHOT_MAGIC, sizeof(snapshot.magic)) == 0 &&
+           snapshot.version == SNAPSHOT_VERSION && snapshot.size == sizeof(Snapshot) &&
+           snapshot.pixelBits == sizeof(FIXEL_FORMAT) * 8 && snapshot.width == WIDTH && snapshot.height == HEIGHT &&
+           snapshot.simHz == simHz && snapshot.blockCount >= 0 && snapshot.blockCount <= MAX_BLOCKS &&
+           snapshot.particles.count >= 0 && snapshot.particles.count <= MAX_PARTICLES;
+}
+
+// 파티클이 particles에 다 들어가지 않으면 아무것도 바꾸지 않고 false
+bool restoreSnapshot(const Snapshot &snapshot, Fixed &simTime, Player &player, Pool<Block, MAX_BLOCKS> &blocks,
+                     ParticleSystem &particles) {
+    if (!particles.restore(snapshot.particles)) {
+        std::cerr << "Error: " << snapshot.particles.count << " snapshot particles do not fit in the particle system." << std::endl;
+        return false;
+    }
+    simTime = snapshot.simTime;
+    player.body = snapshot.player;
+    player.squash = snapshot.squash;
+    player.syncFromBody();
+
+    // 블록은 거꾸로 지우고 저장한 순서대로 만들어서 forEach 순서(충돌 검사 순서)를 그대로 되살립니다.
+    Block* existing[MAX_BLOCKS];
+    int count = 0;
+    blocks.forEach([&](Block &block) {
+        existing[count++] = &block;
+    });
+    while (count > 0) {
+        blocks.destroy(existing[--count]);
+    }
+    for (int i = 0; i < snapshot.blockCount; ++i) {
+        const BlockState &b = snapshot.blocks[i];
+        blocks.create(b.x, b.y, b.w, b.h);
+    }
+    return true;
+}
+
+bool writeSnapshot(const char * path, const Snapshot &snapshot) {
+    FILE * file = fopen(path, "wb");
+    if (file == nullptr || fwrite(&snapshot, sizeof(snapshot), 1, file) != 1) {
+        std::cerr << "Error: cannot write snapshot " << path << "." << std::endl;
+        if (file != nullptr) {
+            fclose(file);
+        }
+        return false;
+    }
+    fclose(file);
+    return true;
+}
+
+bool readSnapshot(const char * path, Snapshot &snapshot, int simHz) {
+    FILE * file = fopen(path, "rb");
+    if (file == nullptr) {
+        std::cerr << "Error: cannot open snapshot " << path << "." << std::endl;
+        return false;
+    }
+    bool ok = fread(&snapshot, sizeof(snapshot), 1, file) == 1 && validSnapshot(snapshot, simHz);
+    fclose(file);
+    if (!ok) {
+        std::cerr << "Error: " << path << " is not a snapshot for this build, screen size and --sim-hz." << std::endl;
+    }
+    return ok;
+}
+
+// 최근 스냅샷을 고정 개수만큼 돌려 쓰는 되감기 버퍼
+// 메모리는 시작할 때 한 번만 잡고, 가득 차면 가장 오래된 것부터 덮어씁니다.
+class RewindBuffer {
+private:
+    Snapshot * slots = nullptr;
+    int capacity = 0;
+    int head = 0;       // 다음에 쓸 칸
+    int count = 0;
+
+public:
+    RewindBuffer(int frames) : capacity(frames) {
+        slots = (Snapshot*)countedAlloc((sizeof(Snapshot) * frames + SURFACE_ALIGN - 1) & ~(SURFACE_ALIGN - 1), SURFACE_ALIGN);
+        memset(slots, 0, sizeof(Snapshot) * frames);
+    }
+    ~RewindBuffer() {
+        countedFree(slots);
+    }
+    RewindBuffer(const RewindBuffer &) = delete;
+    RewindBuffer &operator=(const RewindBuffer &) = delete;
+
+    // 채울 칸을 돌려줍니다.
+    Snapshot &push() {
+        Snapshot &slot = slots[head];
+        head = (head + 1) % capacity;
+        count = std::min(count + 1, capacity);
+        return slot;
+    }
+
+    // 가장 최근 스냅샷을 꺼냅니다. 비었으면 nullptr
+    const Snapshot * pop() {
+        if (count == 0) {
+            return nullptr;
+        }
+        head = (head + capacity - 1) % capacity;
+        count--;
+        return &slots[head];
+    }
+
+    int size() const { return count; }
+    size_t bytes() const { return sizeof(Snapshot) * capacity; }
+};
+
+#include "engine/world_batch.h"
+
+// 봇 월드의 시작 상태: 게임과 같은 자리에 놓인 20x20 공
+Body botStartBody() {
+    const int size = 20;
+    return {toFixed(layoutX(100)), toFixed(GROUND_LEVEL - size), toFixed(size), toFixed(size), 0, 0};
+}
+
+// 봇 입력: 월드와 시간에 따라 정해지는 왼쪽/정지/오른쪽
+int botInput(int world, int tick) {
+    uint32_t h = (uint32_t)world * 2654435761u ^ (uint32_t)(tick / BOT_INPUT_TICKS) * 2246822519u;
+    h ^= h >> 15;
+    h *= 2654435761u;
+    return ((int)((h >> 16) % 3) - 1) * PLAYER_MOVE_SPEED;
+}
+
+// --script: 첫 번째 봇의 입력을 키 이벤트로 바꿉니다. 상태가 바뀌는 키만 이벤트를 만들고 그 수를 돌려줍니다.
+// 키보드 없이 게임 루프 전체를 같은 입력으로 돌릴 수 있어 PGO 학습과 빌드 벤치마크에 씁니다.
+int scriptKeyEvents(uint32_t frame, bool keyLeft, bool keyRight, input_event * events) {
+    int move = botInput(0, (int)frame);
+    int count = 0;
+    auto key = [&](uint16_t code, bool pressed, bool wanted) {
+        if (pressed != wanted) {
+            input_event &ev = events[count++];
+            memset(&ev, 0, sizeof(ev));
+            ev.type = EV_KEY;
+            ev.code = code;
+            ev.value = wanted ? 1 : 0;
+        }
+    };
+    key(KEY_LEFT, keyLeft, move < 0);
+    key(KEY_RIGHT, keyRight, move > 0);
+    return count;
+}
+
+// 배경 색상 채우기 함수
+void fillBackground(RenderTarget &target, Color color) {
+    FIXEL_FORMAT colorData = convertTo(color);
+    fillRect(target, 0, 0, WIDTH, HEIGHT, colorData);
+}
+
+// 땅 색상 채우기 함수
+void fillGround(RenderTarget &target, Color color) {
+    FIXEL_FORMAT colorData = convertTo(color);
+    fillRect(target, 0, GROUND_LEVEL, WIDTH, HEIGHT - GROUND_LEVEL, colorData);
+}
+
+// 팔레트 배경 (--palette)
+// 하늘은 팔레트 구간을 차례로 쓰는 가로 띠로 칠해 두고, 팔레트를 돌려서 띠가 흘러가게 합니다.
+void makeIndexedBackground(IndexedSurface &surface) {
+    for (int i = 0; i < PALETTE_SKY_SHADES; ++i) {
+        // 가운데가 가장 밝은 SKY_BLUE 계열
+        int shade = abs(i - PALETTE_SKY_SHADES / 2) * 6;
+        Color color = {(uint8_t)std::max(0, SKY_BLUE.r - shade), (uint8_t)std::max(0, SKY_BLUE.g - shade),
+                       (uint8_t)std::max(0, SKY_BLUE.b - shade / 2), 0};
+        surface.palette.set(PALETTE_SKY_FIRST + i, color);
+    }
+    surface.palette.set(PALETTE_GROUND, BROWN);
+    for (int y = 0; y < surface.height; ++y) {
+        int index = y >= GROUND_LEVEL ? PALETTE_GROUND : PALETTE_SKY_FIRST + (y / SKY_BAND_HEIGHT) % PALETTE_SKY_SHADES;
+        memset(surface.row(y), index, surface.width);
+    }
+}
+
+// 충돌 상자와 속도 벡터를 백버퍼에 바로 그립니다.
+// 블록 테두리는 블록 안쪽에 그리므로 다음 프레임에 블록을 다시 채울 때 함께 지워집니다.
+// 나머지(플레이어 상자와 속도 화살표)를 덮는 영역을 돌려주므로 다음 프레임에 배경으로 되돌립니다.
+ClipRect drawDebugShapes(RenderTarget &target, const Player &player, Pool<Block, MAX_BLOCKS> &blocks) {
+    const FIXEL_FORMAT boxColor = convertTo(DEBUG_BOX_COLOR);
+    const FIXEL_FORMAT velocityColor = convertTo(DEBUG_VELOCITY_COLOR);
+    blocks.forEach([&](Block &block) {
+        drawRectOutline(target, block.getX(), block.getY(), block.width, block.height, boxColor);
+    });
+
+    const Body &body = player.body;
+    int x = fixedToInt(body.x), y = fixedToInt(body.y);
+    int w = fixedToInt(body.w), h = fixedToInt(body.h);
+    drawRectOutline(target, x, y, w, h, boxColor);
+
+    // 몸 가운데에서 몇 틱 뒤의 위치까지 선을 긋고 끝에 화살촉을 붙입니다.
+    int cx = x + w / 2, cy = y + h / 2;
+    int ex = cx + fixedToInt(body.vx * DEBUG_VELOCITY_TICKS);
+    int ey = cy + fixedToInt(body.vy * DEBUG_VELOCITY_TICKS);
+    drawLine(target, cx, cy, ex, ey, velocityColor);
+    float dx = (float)(ex - cx), dy = (float)(ey - cy);
+    float length = sqrtf(dx * dx + dy * dy);
+    const int head = 6;
+    if (length >= 1.0f) {
+        float ux = dx / length, uy = dy / length;
+        const Point arrow[3] = {
+            {ex, ey},
+            {ex - (int)(ux * head - uy * head / 2), ey - (int)(uy * head + ux * head / 2)},
+            {ex - (int)(ux * head + uy * head / 2), ey - (int)(uy * head - ux * head / 2)},
+        };
+        fillPolygon(target, arrow, 3, velocityColor);
+    }
+
+    ClipRect bounds;
+    bounds.x0 = std::max(0, std::min(x, std::min(cx, ex) - head));
+    bounds.y0 = std::max(0, std::min(y, std::min(cy, ey) - head));
+    bounds.x1 = std::min(target.width, std::max(x + w, std::max(cx, ex) + head + 1));
+    bounds.y1 = std::min(target.height, std::max(y + h, std::max(cy, ey) + head + 1));
+    bounds.x1 = std::max(bounds.x0, bounds.x1);
+    bounds.y1 = std::max(bounds.y0, bounds.y1);
+    return bounds;
+}
+
+// 입력 장치 열기
+int openInputDevice(const char * device) {
+    printf("openInputDevice: %s\n", device);
+    int fd = open(device, O_RDONLY);
+    if (fd == -1) {
+        std::cerr << "Error: cannot open input device " << device << "." << std::endl;
+        return -1;
+    }
+    return fd;
+}
+
+// 키 입력 처리
+void handleKeyEvent(const input_event &ev, bool &key_left_pressed, bool &key_right_pressed, bool &key_rewind_pressed,
+                    bool &running) {
+    if (ev.type != EV_KEY) {
+        return;
+    }
+    if (ev.value == 1) { // 키가 눌림
+        switch (ev.code) {
+            case KEY_LEFT:
+                key_left_pressed = true;
+                break;
+            case KEY_RIGHT:
+                key_right_pressed = true;
+                break;
+            case KEY_BACKSPACE:
+                key_rewind_pressed = true;
+                break;
+            case KEY_ESC:
+                running = false;
+                break;
+        }
+    } else if (ev.value == 0) { // 키가 떼어짐
+        switch (ev.code) {
+            case KEY_LEFT:
+                key_left_pressed = false;
+                break;
+            case KEY_RIGHT:
+                key_right_pressed = false;
+                break;
+            case KEY_BACKSPACE:
+                key_rewind_pressed = false;
+                break;
+        }
+    }
+}
+
+// 실제 장치 없이 쓸 기준 크기의 화면 정보
+void makeHeadlessScreenInfo(fb_var_screeninfo &vinfo, fb_fix_screeninfo &finfo) {
+    memset(&vinfo, 0, sizeof(vinfo));
+    memset(&finfo, 0, sizeof(finfo));
+    vinfo.xres = vinfo.xres_virtual = DEFAULT_SCREEN_WIDTH;
+    vinfo.yres = vinfo.yres_virtual = DEFAULT_SCREEN_HEIGHT;
+    vinfo.bits_per_pixel = sizeof(FIXEL_FORMAT) * 8;
+    finfo.line_length = DEFAULT_SCREEN_WIDTH * sizeof(FIXEL_FORMAT);
+}
+
+// 프레임버퍼 없이 실행할 때 memfd로 가짜 프레임버퍼를 만듭니다.
+int openHeadlessFramebuffer(fb_var_screeninfo &vinfo, fb_fix_screeninfo &finfo) {
+    makeHeadlessScreenInfo(vinfo, finfo);
+
+    int fd = memfd_create("fbgame-headless", 0);
+    if (fd == -1) {
+        std::cerr << "Error: cannot create headless framebuffer." << std::endl;
+        return -1;
+    }
+    if (ftruncate(fd, (long)vinfo.yres_virtual * finfo.line_length * 2) == -1) {
+        std::cerr << "Error: cannot resize headless framebuffer." << std::endl;
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+double nowSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#include "engine/capture.h"
+
+#include "engine/bench.h"
+
+// --worlds: 월드 n개를 봇 입력으로 1분(게임 시간) 동안 진행하고 요약을 출력합니다.
+int runWorlds(int worldCount, int threadCount) {
+    Box level[LEVEL_BLOCKS + 1];
+    int levelCount = makeLevelBoxes(level);
+    WorldBatch batch(worldCount, level, levelCount, botStartBody());
+    WorkerPool workers(threadCount);
+    const int ticks = SIM_TICK_HZ * 60;
+
+    double start = nowSeconds();
+    for (int tick = 0; tick < ticks; ++tick) {
+        if (tick % BOT_INPUT_TICKS == 0) {
+            for (int i = 0; i < worldCount; ++i) {
+                batch.setInput(i, botInput(i, tick));
+            }
+        }
+        batch.step(workers);
+    }
+    double elapsed = nowSeconds() - start;
+
+    long totalBounces = 0;
+    double sumX = 0.0;
+    for (int i = 0; i < worldCount; ++i) {
+        WorldBatch::State state = batch.state(i);
+        totalBounces += state.bounces;
+        sumX += state.x / (double)FIXED_ONE;
+    }
+    printf("worlds = %d, ticks = %d, threads = %d, elapsed = %.3f s, %.2f M world-steps/s\n",
+           worldCount, ticks, workers.size(), elapsed, (double)worldCount * ticks / elapsed / 1e6);
+    printf("average x = %.1f, bounces per world = %.1f\n", sumX / worldCount, (double)totalBounces / worldCount);
+    for (int i = 0; i < std::min(worldCount, 4); ++i) {
+        WorldBatch::State state = batch.state(i);
+        printf("world %d: x = %.2f, y = %.2f, vy = %.2f, bounces = %d\n", i, state.x / (double)FIXED_ONE,
+               state.y / (double)FIXED_ONE, state.vy / (double)FIXED_ONE, state.bounces);
+    }
+    return 0;
+}
+
+// --shm-read: 다른 프로세스가 공개하는 프레임 링을 읽습니다.
+// 프레임마다 제자리에서 체크섬을 계산하고, 게임이 체크섬을 남긴 프레임(--record/--replay)은 비교합니다.
+// 2초 동안 새 프레임이 없으면 끝냅니다.
+int runFrameReader(const char * name) {
+    FrameRingReader reader;
+    if (!reader.open(name)) {
+        return 1;
+    }
+    printf("frame ring %s: %dx%d\n", name, reader.width(), reader.height());
+
+    uint32_t expected = 0, computed = 0;
+    auto visit = [&](const RenderTarget &target, uint64_t, uint32_t checksum) {
+        expected = checksum;
+        computed = frameChecksum(target);
+    };
+    long frames = 0, skipped = 0, checked = 0, mismatches = 0;
+    uint64_t last = 0;
+    double idleSince = nowSeconds();
+    while (nowSeconds() - idleSince < 2.0) {
+        uint64_t frame;
+        if (reader.latest() == last || !reader.readLatest(visit, frame) || frame + 1 == last) {
+            usleep(1000);
+            continue;
+        }
+        if (last != 0 && frame + 1 > last + 1) {
+            skipped += frame - last;
+        }
+        if (expected != 0) {
+            checked++;
+            if (computed != expected) {
+                mismatches++;
+            }
+        }
+        frames++;
+        last = frame + 1;
+        idleSince = nowSeconds();
+    }
+    printf("frames read = %ld, skipped = %ld, retries = %ld, checksums checked = %ld, mismatches = %ld\n",
+           frames, skipped, reader.retries, checked, mismatches);
+    return mismatches == 0 ? 0 : 2;
+}
+
+// --capture-play: 녹화 파일을 풀어 every 프레임마다 prefix00000.bmp 처럼 저장합니다.
+// 프레임마다 체크섬을 확인하고, 녹화 중에 버려진 프레임 번호는 빈 칸으로 셉니다.
+int runCapturePlayer(const char * path, const char * prefix, int every) {
+    FILE * file = fopen(path, "rb");
+    if (file == nullptr) {
+        std::cerr << "Error: cannot open capture file " << path << "." << std::endl;
+        return 1;
+    }
+    CaptureHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, CAPTURE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != CAPTURE_VERSION || header.pixelBits != sizeof(FIXEL_FORMAT) * 8 ||
+        header.width <= 0 || header.height <= 0) {
+        std::cerr << "Error: " << path << " is not a capture file for this pixel format." << std::endl;
+        fclose(file);
+        return 1;
+    }
+    int count = header.width * header.height;
+    std::vector<FIXEL_FORMAT> frame(count, 0);
+    std::vector<uint8_t> encoded(deltaBound(count));
+    RenderTarget target;
+    target.base = (uint8_t*)frame.data();
+    target.stride = header.width * sizeof(FIXEL_FORMAT);
+    target.width = header.width;
+    target.height = header.height;
+    target.bitsPerPixel = header.pixelBits;
+
+    long frames = 0, gaps = 0, mismatches = 0, images = 0;
+    long expectedFrame = -1;
+    CaptureFrameHeader record;
+    while (fread(&record, sizeof(record), 1, file) == 1) {
+        if (record.bytes > encoded.size() || fread(encoded.data(), 1, record.bytes, file) != record.bytes ||
+            !decodeDelta(encoded.data(), record.bytes, frame.data(), count)) {
+            std::cerr << "Error: corrupt capture data at frame " << record.frame << "." << std::endl;
+            fclose(file);
+            return 1;
+        }
+        if (expectedFrame >= 0 && (long)record.frame > expectedFrame) {
+            gaps += record.frame - expectedFrame;
+        }
+        expectedFrame = (long)record.frame + 1;
+        if (frameChecksum(target) != record.checksum) {
+            mismatches++;
+        }
+        if (frames % every == 0) {
+            char name[512];
+            snprintf(name, sizeof(name), "%s%05u.bmp", prefix, record.frame);
+            if (writeBmp(name, frame.data(), header.width, header.height)) {
+                images++;
+            }
+        }
+        frames++;
+    }
+    fclose(file);
+    printf("capture %s: %dx%d, %ld frames, %ld dropped frames, %ld images written, checksum mismatches = %ld\n",
+           path, header.width, header.height, frames, gaps, images, mismatches);
+    return mismatches == 0 ? 0 : 2;
+}
+
+int runBenchmark(const char * name) {
+    bool found = false;
+    for (const Benchmark &bench : BENCHMARKS) {
+        if (strcmp(name, "all") == 0 || strcmp(name, bench.name) == 0) {
+            bench.run();
+            found = true;
+        }
+    }
+    if (!found) {
+        std::cerr << "Error: unknown benchmark " << name << "." << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+void printUsage(const char * name) {
+    printf("usage: %s [--headless] [--record file] [--replay file] [--threads n] [--overlay]\n", name);
+    printf("       [--sim-hz n] [--hud] [--debug] [--palette]\n");
+    printf("       [--present copy|stream|delta] [--scale 1|2|4|auto]\n");
+    printf("       [--shm name] [--capture file] [--asset-io auto|uring|threads]\n");
+    printf("       [--save-state file] [--load-state file] [--script frames]\n");
+    printf("       %s --shm-read name\n", name);
+    printf("       %s --capture-play file prefix [--every n]\n", name);
+    printf("       %s --worlds n [--threads n]\n", name);
+    printf("       %s --bench <name|all>\n", name);
+}
+
+
+int main(int argc, char ** argv) {
+    bool headless = false;
+    const char * recordPath = nullptr;
+    const char * replayPath = nullptr;
+    int threadCount = 1;
+    int simHz = SIM_TICK_HZ;
+    bool overlayEnabled = false;
+    bool hudEnabled = false;
+    bool debugEnabled = false;
+    bool paletteEnabled = false;
+    int worldCount = 0;
+    const char * shmName = nullptr;
+    const char * capturePath = nullptr;
+    const char * saveStatePath = nullptr;
+    const char * loadStatePath = nullptr;
+    int scriptFrames = 0;
+    const char * playPath = nullptr;
+    const char * playPrefix = nullptr;
+    int playEvery = 1;
+    AssetIo assetIo = ASSET_IO_AUTO;
+    PresentMode presentMode = PRESENT_STREAM;
+    int upscale = 1;    // 0이면 화면 크기를 보고 고릅니다.
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (strcmp(argv[i], "--overlay") == 0) {
+            overlayEnabled = true;
+        } else if (strcmp(argv[i], "--hud") == 0) {
+            hudEnabled = true;
+        } else if (strcmp(argv[i], "--debug") == 0) {
+            debugEnabled = true;
+        } else if (strcmp(argv[i], "--palette") == 0) {
+            paletteEnabled = true;
+        } else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc) {
+            shmName = argv[++i];
+        } else if (strcmp(argv[i], "--shm-read") == 0 && i + 1 < argc) {
+            return runFrameReader(argv[i + 1]);
+        } else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            capturePath = argv[++i];
+        } else if (strcmp(argv[i], "--capture-play") == 0 && i + 2 < argc) {
+            playPath = argv[++i];
+            playPrefix = argv[++i];
+        } else if (strcmp(argv[i], "--every") == 0 && i + 1 < argc) {
+            playEvery = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--save-state") == 0 && i + 1 < argc) {
+            saveStatePath = argv[++i];
+        } else if (strcmp(argv[i], "--load-state") == 0 && i + 1 < argc) {
+            loadStatePath = argv[++i];
+        } else if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+            scriptFrames = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--asset-io") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "auto") == 0) {
+                assetIo = ASSET_IO_AUTO;
+            } else if (strcmp(argv[i], "uring") == 0) {
+                assetIo = ASSET_IO_URING;
+            } else if (strcmp(argv[i], "threads") == 0) {
+                assetIo = ASSET_IO_THREADS;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--worlds") == 0 && i + 1 < argc) {
+            worldCount = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--present") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "copy") == 0) {
+                presentMode = PRESENT_COPY;
+            } else if (strcmp(argv[i], "stream") == 0) {
+                presentMode = PRESENT_STREAM;
+            } else if (strcmp(argv[i], "delta") == 0) {
+                presentMode = PRESENT_DELTA;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "auto") == 0) {
+                upscale = 0;
+            } else {
+                upscale = atoi(argv[i]);
+                if (upscale != 1 && upscale != 2 && upscale != 4) {
+                    printUsage(argv[0]);
+                    return 1;
+                }
+            }
+        } else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            return runBenchmark(argv[i + 1]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threadCount = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--sim-hz") == 0 && i + 1 < argc) {
+            simHz = std::min(SIM_TICK_HZ * 4, std::max(1, atoi(argv[++i])));
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (worldCount > 0) {
+        return runWorlds(worldCount, threadCount);
+    }
+    if (playPath != nullptr) {
+        return runCapturePlayer(playPath, playPrefix, playEvery);
+    }
+    InputRecorder recorder;
+    InputReplayer replayer;
+    if (recordPath != nullptr && !recorder.open(recordPath)) {
+        return 1;
+    }
+    if (replayPath != nullptr && !replayer.open(replayPath)) {
+        return 1;
+    }
+    // 리플레이는 녹화할 때의 설정으로 돌립니다. 명령줄과 다르면 알리고 녹화된 값을 씁니다.
+    uint32_t drawFlags = (overlayEnabled ? REPLAY_OVERLAY : 0) | (hudEnabled ? REPLAY_HUD : 0) |
+                         (debugEnabled ? REPLAY_DEBUG : 0) | (paletteEnabled ? REPLAY_PALETTE : 0);
+    if (replayPath != nullptr) {
+        const ReplaySettings &recorded = replayer.settings;
+        if (recorded.simHz != simHz || recorded.upscale != upscale || recorded.flags != drawFlags) {
+            printf("replay: using recorded settings --sim-hz %d --scale %d%s%s%s%s\n", recorded.simHz, recorded.upscale,
+                   recorded.flags & REPLAY_OVERLAY ? " --overlay" : "", recorded.flags & REPLAY_HUD ? " --hud" : "",
+                   recorded.flags & REPLAY_DEBUG ? " --debug" : "", recorded.flags & REPLAY_PALETTE ? " --palette" : "");
+        }
+        simHz = recorded.simHz;
+        upscale = recorded.upscale;
+        drawFlags = recorded.flags;
+        overlayEnabled = (drawFlags & REPLAY_OVERLAY) != 0;
+        hudEnabled = (drawFlags & REPLAY_HUD) != 0;
+        debugEnabled = (drawFlags & REPLAY_DEBUG) != 0;
+        paletteEnabled = (drawFlags & REPLAY_PALETTE) != 0;
+    }
+
+    // 스프라이트 시트는 프레임버퍼와 입력 장치를 여는 동안 백그라운드에서 읽습니다.
+    AssetLoader assets;
+    if (!assets.start(assetIo, ASSET_DECODE_THREADS)) {
+        return 1;
+    }
+    int ballSheet = assets.request("ball_sheet.bmp");
+
+    atexit(enableInputEcho);
+    disableInputEcho();
+
+    fb_var_screeninfo vinfo;
+    fb_fix_screeninfo finfo;
+    int fb_fd;
+
+    if (headless) {
+        fb_fd = openHeadlessFramebuffer(vinfo, finfo);
+        if (fb_fd == -1) {
+            return 1;
+        }
+    } else {
+        // 프레임버퍼 장치 열기
+        fb_fd = open("/dev/fb0", O_RDWR);
+        if (fb_fd == -1) {
+            std::cerr << "Error: cannot open framebuffer device." << std::endl;
+            return 1;
+        }
+
+        // 가변 화면 정보 가져오기
+        if (ioctl(fb_fd, FBIOGET_VSCREENINFO, &vinfo)) {
+            std::cerr << "Error reading variable information." << std::endl;
+            close(fb_fd);
+            return 1;
+        }
+
+        // 고정 화면 정보 가져오기
+        if (ioctl(fb_fd, FBIOGET_FSCREENINFO, &finfo)) {
+            std::cerr << "Error reading fixed information." << std::endl;
+            close(fb_fd);
+            return 1;
+        }
+    }
+
+    // 화면 크기 계산
+    long screensize = vinfo.yres_virtual * finfo.line_length * 2;
+    printf("width = %d, height = %d, xres_virtual = %d, yres_virtual = %d\n",
+           vinfo.xres, vinfo.yres, vinfo.xres_virtual, vinfo.yres_virtual);
+    printf("screensize = %ld\n", screensize);
+    printf("bits_per_pixel = %d\n", vinfo.bits_per_pixel);
+
+    // 메모리 매핑
+    uint8_t* fb_ptr = (uint8_t*)mmap(0, screensize, PROT_READ | PROT_WRITE, MAP_SHARED, fb_fd, 0);
+    if ((intptr_t)fb_ptr == -1) {
+        std::cerr << "Error: failed to map framebuffer device to memory." << std::endl;
+        close(fb_fd);
+        return 1;
+    }
+
+    // 그리기 대상은 여기서 한 번만 계산합니다.
+    if (vinfo.bits_per_pixel != sizeof(FIXEL_FORMAT) * 8) {
+        std::cerr << "Warning: framebuffer is " << vinfo.bits_per_pixel << "bpp but FIXEL_FORMAT is "
+                  << sizeof(FIXEL_FORMAT) * 8 << "bpp." << std::endl;
+    }
+    RenderTarget fb = makeRenderTarget(fb_ptr, vinfo, finfo);
+
+    // 내부 해상도는 화면 크기를 배율로 나눈 값입니다.
+    // 게임은 작은 백버퍼에 그리고, 내보낼 때만 화면 크기로 늘립니다.
+    if (upscale == 0) {
+        upscale = 1;
+        for (int s = 4; s > 1; s /= 2) {
+            if ((int)vinfo.yres / s >= MIN_AUTO_RENDER_HEIGHT) {
+                upscale = s;
+                break;
+            }
+        }
+    }
+    setRenderSize(vinfo.xres / upscale, vinfo.yres / upscale);
+    printf("render = %dx%d (x%d)\n", WIDTH, HEIGHT, upscale);
+
+    // 화면 크기는 리플레이에 맞춰 바꿀 수 없으므로 다르면 체크섬을 비교하지 않고 멈춥니다.
+    if (replayPath != nullptr &&
+        (replayer.settings.screenWidth != vinfo.xres || replayer.settings.screenHeight != vinfo.yres)) {
+        std::cerr << "Error: replay was recorded on a " << replayer.settings.screenWidth << "x" << replayer.settings.screenHeight
+                  << " screen, this screen is " << vinfo.xres << "x" << vinfo.yres << "." << std::endl;
+        munmap(fb_ptr, screensize);
+        close(fb_fd);
+        return 1;
+    }
+    if (recordPath != nullptr) {
+        recorder.describe({(uint16_t)vinfo.xres, (uint16_t)vinfo.yres, (uint16_t)upscale, (uint16_t)simHz, drawFlags});
+    }
+
+    // 백버퍼와 미리 그려둔 배경 레이어 (0으로 초기화되므로 리플레이 체크섬이 안정적입니다)
+    Surface backBuffer(WIDTH, HEIGHT);
+    Surface background(WIDTH, HEIGHT);
+    RenderTarget buffer = backBuffer.target();
+    RenderTarget backgroundTarget = background.target();
+
+    // 입력 장치 파일 열기
+    int keyboard_fd = -1;
+
+    // 리플레이와 스크립트 실행 중에는 키보드 대신 파일이나 봇에서 입력을 받습니다.
+    if (replayPath == nullptr && scriptFrames == 0) {
+        // 키보드 파일 찾기
+        for (int eventid = 0; eventid < 32; ++eventid) {
+            char device[32];
+            snprintf(device, sizeof(device), "/dev/input/event%d", eventid);
+            int fd = openInputDevice(device);
+            if (fd != -1) {
+                keyboard_fd = fd;
+                int flags = fcntl(keyboard_fd, F_GETFL, 0);
+                fcntl(keyboard_fd, F_SETFL, flags | O_NONBLOCK);
+                break;
+            }
+        }
+
+        if (
+            keyboard_fd == -1
+        ) {
+            munmap(fb_ptr, screensize);
+            close(fb_fd);
+            return 1;
+        }
+    }
+
+    // 플레이어 초기화
+    Atlas ballAtlas;
+    if (!ballAtlas.attach(assets.wait(ballSheet), "ball_sheet.atlas")) {
+        munmap(fb_ptr, screensize);
+        close(fb_fd);
+        return 1;
+    }
+    Animation ballAnimation;
+    ballAnimation.fromPrefix(ballAtlas, "ball");
+    Player player(layoutX(100), GROUND_LEVEL, &ballAtlas, ballAnimation);
+
+    Pool<Block, MAX_BLOCKS> blocks;
+    for (int i = 0; i < LEVEL_BLOCKS; i++) {
+        int x, y;
+        levelBlockPosition(i, x, y);
+        blocks.create(x, y, LEVEL_BLOCK_WIDTH, LEVEL_BLOCK_HEIGHT);
+    }
+
+    // 반투명 오버레이 (화면에 내보낼 때 매 프레임 합성)
+    Image * overlay = nullptr;
+    if (overlayEnabled) {
+        overlay = new Image(WIDTH, HEIGHT);
+        makeVignetteOverlay(*overlay);
+    }
+
+    // 프레임 단위 임시 메모리와 힙 할당 통계
+    FrameArena frameArena(FRAME_ARENA_SIZE);
+    size_t steadyAllocs = 0;
+    size_t maxFrameAllocs = 0;
+
+    // 그리기 명령 목록과 실행용 작업 스레드
+    DrawList drawList;
+    WorkerPool workers(threadCount);
+    Presenter presenter(presentMode, fb.width, fb.height, upscale);
+    long totalRecorded = 0;
+
+    // 물리 스텝 길이 (틱 단위)와 아직 진행하지 않은 시간
+    const Fixed simDt = FIXED_ONE * SIM_TICK_HZ / simHz;
+    Fixed simTime = 0;
+    long simSteps = 0;
+    BroadPhase broadPhase(MAX_BLOCKS + 2);
+
+    // 상태 표시 (글자는 시작할 때 한 번 변환하고, 문자열은 캐시에서 꺼내 씁니다)
+    BitmapFont * hudFont = nullptr;
+    TextCache * hudText = nullptr;
+    if (hudEnabled) {
+        hudFont = new BitmapFont(convertTo(HUD_COLOR), HUD_SCALE);
+        hudText = new TextCache(*hudFont);
+    }
+    double hudFps = 0.0;
+    double hudTime = nowSeconds();
+
+    // 다른 프로세스에 프레임을 보여 주는 공유 메모리 링 (--shm)
+    FrameRingWriter * frameRing = nullptr;
+    if (shmName != nullptr) {
+        frameRing = new FrameRingWriter();
+        if (!frameRing->open(shmName, WIDTH, HEIGHT)) {
+            delete frameRing;
+            frameRing = nullptr;
+        }
+    }
+
+    // 디스크 쓰기는 녹화 스레드가 하므로 게임 루프는 프레임 복사만 합니다. (--capture)
+    FrameCapture * capture = nullptr;
+    if (capturePath != nullptr) {
+        capture = new FrameCapture();
+        if (!capture->open(capturePath, WIDTH, HEIGHT)) {
+            delete capture;
+            capture = nullptr;
+        }
+    }
+
+    // 튈 때 날리는 먼지
+    ParticleSystem particles(MAX_PARTICLES);
+    const FIXEL_FORMAT dustColor = convertTo(DUST_COLOR);
+    long totalMerged = 0;
+
+    // 충돌 상자와 속도 벡터 (--debug). 지난 프레임에 그린 영역을 기억해 두고 지웁니다.
+    ClipRect debugBounds = {0, 0, 0, 0};
+
+    // 키 상태를 저장할 플래그
+    bool key_left_pressed = false;
+    bool key_right_pressed = false;
+    bool key_rewind_pressed = false;
+
+    // 프레임마다 시작할 때의 스냅샷 (Backspace를 누르고 있으면 한 프레임씩 되감습니다)
+    RewindBuffer rewind(REWIND_FRAMES);
+    Snapshot stateFile;
+    if (loadStatePath != nullptr && readSnapshot(loadStatePath, stateFile, simHz)) {
+        restoreSnapshot(stateFile, simTime, player, blocks, particles);
+    }
+
+    // pollfd 구조체 설정
+    struct pollfd fds;
+    fds.fd = keyboard_fd;
+    fds.events = POLLIN;
+
+    // 이벤트 루프
+    bool running = true;
+    uint32_t frame = 0;
+    double startTime = nowSeconds();
+
+    // --palette이면 배경을 인덱스 서피스로 만들어 두고 펼친 결과를 배경 레이어로 씁니다.
+    IndexedSurface * indexedBackground = nullptr;
+    if (paletteEnabled) {
+        indexedBackground = new IndexedSurface(WIDTH, HEIGHT);
+        makeIndexedBackground(*indexedBackground);
+        drawIndexed(backgroundTarget, 0, 0, *indexedBackground, false);
+    } else {
+        fillBackground(backgroundTarget, SKY_BLUE);
+        fillGround(backgroundTarget, BROWN);
+    }
+    copyRect(buffer, 0, 0, backgroundTarget, 0, 0, WIDTH, HEIGHT);
+
+    // 플레이 중에 스프라이트 시트 파일이 바뀌면 백그라운드에서 다시 읽고, 준비된 프레임에 바꿔 끼웁니다.
+    // 읽고 변환하는 동안 게임 루프는 기다리지 않습니다. 파일이 그대로면 아무것도 하지 않습니다.
+    struct stat sheetStat;
+    timespec sheetTime = {0, 0};
+    if (stat("ball_sheet.bmp", &sheetStat) == 0) {
+        sheetTime = sheetStat.st_mtim;
+    }
+    int sheetReload = -1;
+    int sheetReloads = 0;
+    double worstSheetSwap = 0.0;
+
+    while (running) {
+        struct input_event ev;
+        size_t allocsAtFrameStart = g_heapAllocCount.load(std::memory_order_relaxed);
+
+        frameArena.reset();
+        DirtyRect* dirtyRects = frameArena.allocArray<DirtyRect>(MAX_DIRTY_RECTS);
+        int dirtyCount = 0;
+        drawList.begin(frameArena, MAX_DRAW_COMMANDS);
+
+        if (replayPath != nullptr) {
+            while (replayer.nextEvent(frame, ev)) {
+                // --replay와 --record를 함께 주면 같은 입력으로 체크섬을 다시 기록합니다.
+                if (recordPath != nullptr) {
+                    recorder.event(frame, ev);
+                }
+                handleKeyEvent(ev, key_left_pressed, key_right_pressed, key_rewind_pressed, running);
+            }
+        } else if (scriptFrames > 0) {
+            input_event events[2];
+            int count = scriptKeyEvents(frame, key_left_pressed, key_right_pressed, events);
+            for (int i = 0; i < count; ++i) {
+                if (recordPath != nullptr) {
+                    recorder.event(frame, events[i]);
+                }
+                handleKeyEvent(events[i], key_left_pressed, key_right_pressed, key_rewind_pressed, running);
+            }
+        } else {
+            // poll 함수를 사용하여 키보드 이벤트 폴링
+            int ret = poll(&fds, 1, 1);
+            if (ret > 0) {
+                if (fds.revents & POLLIN) {
+                    if (read(keyboard_fd, &ev, sizeof(ev)) > 0) {
+                        if (recordPath != nullptr) {
+                            recorder.event(frame, ev);
+                        }
+                        handleKeyEvent(ev, key_left_pressed, key_right_pressed, key_rewind_pressed, running);
+                    }
+                }
+            }
+        }
+
+        if (sheetReload == -1 && frame % ASSET_RELOAD_FRAMES == 0 && stat("ball_sheet.bmp", &sheetStat) == 0 &&
+            (sheetStat.st_mtim.tv_sec != sheetTime.tv_sec || sheetStat.st_mtim.tv_nsec != sheetTime.tv_nsec)) {
+            sheetTime = sheetStat.st_mtim;
+            sheetReload = assets.request("ball_sheet.bmp");
+        }
+        if (sheetReload != -1 && assets.state(sheetReload) >= ASSET_READY) {
+            double swapStart = nowSeconds();
+            if (ballAtlas.replace(assets.take(sheetReload))) {
+                sheetReloads++;
+            } else {
+                std::cerr << "Warning: cannot reload ball_sheet.bmp, keeping the old sheet." << std::endl;
+            }
+            worstSheetSwap = std::max(worstSheetSwap, nowSeconds() - swapStart);
+            sheetReload = -1;
+        }
+
+        // 키 상태에 따라 플레이어 이동
+        int moveVal = 0;
+        if (key_left_pressed) {
+            moveVal -= PLAYER_MOVE_SPEED;
+        }
+        if (key_right_pressed) {
+            moveVal += PLAYER_MOVE_SPEED;
+        }
+        player.remove(drawList, background);
+        dirtyRects[dirtyCount++] = player.drawn;
+
+        // 상태 표시 영역을 배경으로 되돌린 뒤 다시 씁니다.
+        // 기록/리플레이 중에는 체크섬이 같아지도록 벽시계 FPS 대신 두 쪽에서 같은 틱 주기를 표시합니다.
+        // 지우는 폭은 한 줄에 쓸 수 있는 가장 긴 글자 수로 잡아 긴 줄의 글자가 남지 않게 합니다.
+        if (hudText != nullptr) {
+            const int lineHeight = hudFont->height + HUD_SCALE * 2;
+            const int hudWidth = std::min(WIDTH - HUD_X, TEXT_RUN_MAX_CHARS * hudFont->advance);
+            drawList.copy(LAYER_BACKGROUND, HUD_X, HUD_Y, hudWidth, lineHeight * HUD_LINES, background, HUD_X, HUD_Y);
+            dirtyRects[dirtyCount++] = {HUD_X, HUD_Y, hudWidth, lineHeight * HUD_LINES};
+            if (frame % 30 == 0 && frame > 0) {
+                double now = nowSeconds();
+                hudFps = 30.0 / (now - hudTime);
+                hudTime = now;
+            }
+            char line[TEXT_RUN_MAX_CHARS + 1];
+            snprintf(line, sizeof(line), "FRAME %u", frame);
+            hudText->draw(drawList, LAYER_OVERLAY, HUD_X, HUD_Y, line);
+            if (recordPath != nullptr || replayPath != nullptr) {
+                snprintf(line, sizeof(line), "SIM %d HZ", simHz);
+            } else {
+                snprintf(line, sizeof(line), "FPS %.1f", hudFps);
+            }
+            hudText->draw(drawList, LAYER_OVERLAY, HUD_X, HUD_Y + lineHeight, line);
+            snprintf(line, sizeof(line), "DUST %d", particles.size());
+            hudText->draw(drawList, LAYER_OVERLAY, HUD_X, HUD_Y + lineHeight * 2, line);
+            snprintf(line, sizeof(line), "PRESENT %.1f KB", presenter.lastFrameBytes / 1024.0);
+            hudText->draw(drawList, LAYER_OVERLAY, HUD_X, HUD_Y + lineHeight * 3, line);
+        }
+
+        // 지난 프레임에 파티클을 그린 영역도 배경으로 되돌립니다.
+        const ClipRect dust = particles.bounds;
+        if (dust.x0 < dust.x1) {
+            drawList.copy(LAYER_BACKGROUND, dust.x0, dust.y0, dust.x1 - dust.x0, dust.y1 - dust.y0, background, dust.x0, dust.y0);
+            dirtyRects[dirtyCount++] = {dust.x0, dust.y0, dust.x1 - dust.x0, dust.y1 - dust.y0};
+        }
+        // 팔레트를 돌린 프레임에는 배경 레이어와 화면 전체를 인덱스 배경에서 다시 펼칩니다.
+        if (indexedBackground != nullptr && frame > 0 && frame % PALETTE_CYCLE_FRAMES == 0) {
+            indexedBackground->palette.cycle(PALETTE_SKY_FIRST, PALETTE_SKY_SHADES);
+            drawIndexed(backgroundTarget, 0, 0, *indexedBackground, false);
+            drawList.indexed(LAYER_BACKGROUND, 0, 0, WIDTH, HEIGHT, *indexedBackground, 0, 0, false);
+            dirtyRects[dirtyCount++] = {0, 0, WIDTH, HEIGHT};
+        }
+        if (debugBounds.x0 < debugBounds.x1) {
+            const ClipRect &b = debugBounds;
+            drawList.copy(LAYER_BACKGROUND, b.x0, b.y0, b.x1 - b.x0, b.y1 - b.y0, background, b.x0, b.y0);
+            dirtyRects[dirtyCount++] = {b.x0, b.y0, b.x1 - b.x0, b.y1 - b.y0};
+        }
+
+        // 되감는 동안은 시뮬레이션을 멈추고 지난 스냅샷을 하나씩 되돌립니다. 버퍼가 비면 그대로 멈춰 있습니다.
+        if (key_rewind_pressed) {
+            const Snapshot * previous = rewind.pop();
+            if (previous != nullptr) {
+                restoreSnapshot(*previous, simTime, player, blocks, particles);
+            }
+        } else if (!saveSnapshot(rewind.push(), frame, simHz, simTime, player, blocks, particles)) {
+            // 다 담지 못한 칸은 되감기에 쓰지 않습니다.
+            rewind.pop();
+        }
+
+        // 물리는 화면과 별도로 simHz로 진행합니다. 스텝이 길어져도 swept 충돌이므로 뚫고 지나가지 않습니다.
+        // 브로드 페이즈로 이번 스텝에 닿을 수 있는 상자만 골라 stepBody에 넘깁니다.
+        // 상자 뒤에 플레이어가 움직일 수 있는 범위를 하나 더 붙여 함께 정렬합니다.
+        Box* boxes = frameArena.allocArray<Box>(MAX_BLOCKS + 2);
+        Box* candidates = frameArena.allocArray<Box>(MAX_BLOCKS + 1);
+        CollisionPair* pairs = frameArena.allocArray<CollisionPair>(MAX_COLLISION_PAIRS);
+        int boxCount = 0;
+        boxes[boxCount++] = groundBox();
+        blocks.forEach([&](Block &block) {
+            boxes[boxCount++] = block.box();
+        });
+        if (!key_rewind_pressed) {
+            simTime += FIXED_ONE;
+        }
+        while (simTime >= simDt) {
+            player.body.vx = toFixed(moveVal);
+            boxes[boxCount] = sweptBounds(player.body, simDt, toFixed(GRAVITY), toFixed(BOUND_GRAVITY));
+            broadPhase.update(boxes, boxCount + 1);
+            int pairCount = broadPhase.findPairs(pairs, MAX_COLLISION_PAIRS);
+            int candidateCount = 0;
+            for (int i = 0; i < pairCount; ++i) {
+                if (pairs[i].a == boxCount) {
+                    candidates[candidateCount++] = boxes[pairs[i].b];
+                } else if (pairs[i].b == boxCount) {
+                    candidates[candidateCount++] = boxes[pairs[i].a];
+                }
+            }
+            unsigned contacts = stepBody(player.body, candidates, candidateCount, simDt, toFixed(GRAVITY), toFixed(BOUND_GRAVITY));
+            if (contacts & (1u << TOP)) {
+                // 위에 떨어져 튀어 오를 때 발밑에서 먼지를 날리고 공을 찌그러뜨립니다.
+                player.land();
+                float footX = (player.body.x + player.body.w / 2) / (float)FIXED_ONE;
+                float footY = (player.body.y + player.body.h) / (float)FIXED_ONE - 1.0f;
+                particles.emit(footX, footY, DUST_PER_BOUNCE, 3.0f, 30.0f, dustColor);
+            }
+            simTime -= simDt;
+            simSteps++;
+        }
+        player.syncFromBody();
+        if (!key_rewind_pressed) {
+            particles.update();
+        }
+
+        blocks.forEach([&](Block &block) {
+            block.draw(drawList);
+            if (dirtyCount < MAX_DIRTY_RECTS) {
+                dirtyRects[dirtyCount++] = {block.getX(), block.getY(), block.width, block.height};
+            }
+        });
+
+        // 플레이어 그리기
+        player.draw(drawList);
+
+        // 기록된 명령을 정렬/병합한 뒤 백버퍼에 실행
+        drawList.sortAndMerge();
+        drawList.execute(buffer, workers);
+        totalRecorded += drawList.recorded;
+        totalMerged += drawList.merged;
+        dirtyRects[dirtyCount++] = player.drawn;
+
+        // 파티클은 모든 그리기 명령 위에 바로 찍습니다.
+        particles.render(buffer, 2);
+        if (particles.bounds.x0 < particles.bounds.x1) {
+            const ClipRect &b = particles.bounds;
+            dirtyRects[dirtyCount++] = {b.x0, b.y0, b.x1 - b.x0, b.y1 - b.y0};
+        }
+
+        if (debugEnabled) {
+            debugBounds = drawDebugShapes(buffer, player, blocks);
+            const ClipRect &b = debugBounds;
+            dirtyRects[dirtyCount++] = {b.x0, b.y0, b.x1 - b.x0, b.y1 - b.y0};
+        }
+
+        uint32_t checksum = 0;
+        if (recordPath != nullptr || replayPath != nullptr) {
+            checksum = frameChecksum(buffer);
+            if (recordPath != nullptr) {
+                recorder.frameEnd(frame, checksum);
+            }
+            if (replayPath != nullptr) {
+                replayer.frameEnd(frame, checksum);
+            }
+        }
+
+        // 첫 프레임만 전체를 복사하고, 이후에는 바뀐 영역만 프레임버퍼로 보냅니다.
+        if (overlay != nullptr) {
+            updateScreenWithOverlay(fb, buffer, *overlay, presenter);
+        } else if (frame == 0) {
+            updateScreen(fb, buffer, presenter);
+        } else {
+            for (int i = 0; i < dirtyCount; ++i) {
+                updateRect(fb, buffer, dirtyRects[i].x, dirtyRects[i].y, dirtyRects[i].w, dirtyRects[i].h, presenter);
+            }
+        }
+        presenter.endFrame();
+        if (frameRing != nullptr) {
+            frameRing->publish(buffer, frame, checksum);
+        }
+        if (capture != nullptr) {
+            capture->push(buffer, frame);
+        }
+
+        size_t frameAllocs = g_heapAllocCount.load(std::memory_order_relaxed) - allocsAtFrameStart;
+        if (frame >= WARMUP_FRAMES) {
+            steadyAllocs += frameAllocs;
+            if (frameAllocs > maxFrameAllocs) {
+                maxFrameAllocs = frameAllocs;
+            }
+        }
+        frame++;
+
+        if (replayPath != nullptr) {
+            // 리플레이는 고정 타임스텝으로 쉬지 않고 실행하여 성능을 측정합니다.
+            if (replayer.finished(frame)) {
+                running = false;
+            }
+        } else if (scriptFrames > 0) {
+            // 스크립트 실행도 쉬지 않고 정해진 프레임 수만큼 돌립니다.
+            if (frame >= (uint32_t)scriptFrames) {
+                running = false;
+            }
+        } else {
+            // 간단한 지연
+            usleep(16000); // 약 60 FPS
+        }
+    }
+
+    double elapsed = nowSeconds() - startTime;
+    printf("frames = %u, elapsed = %.3f s, avg frame = %.3f ms\n", frame, elapsed, frame > 0 ? elapsed * 1000.0 / frame : 0.0);
+    printf("heap allocations after warmup = %zu (max %zu per frame), arena peak = %zu bytes\n",
+           steadyAllocs, maxFrameAllocs, frameArena.peakUsed());
+    if (frame > 0) {
+        printf("draw list: %.1f commands recorded, %.1f merged per frame (%d threads)\n",
+               (double)totalRecorded / frame, (double)totalMerged / frame, workers.size());
+        printf("physics: %d Hz, %.2f steps per frame\n", simHz, (double)simSteps / frame);
+        printf("present: %.1f KB written per frame (max %.1f KB)\n",
+               (double)presenter.totalBytes / presenter.frames / 1024.0, presenter.maxFrameBytes / 1024.0);
+    }
+    if (replayPath != nullptr) {
+        printf("replay: %d checksum mismatches, %d records out of step\n", replayer.mismatches, replayer.desyncs);
+    }
+    if (hudText != nullptr) {
+        printf("hud text cache: %ld hits, %ld misses\n", hudText->hits, hudText->misses);
+    }
+
+    // 메모리 매핑 해제 및 파일 닫기
+    if (frameRing != nullptr) {
+        printf("shared frames: %ld published to %s\n", frameRing->published, shmName);
+    }
+    printf("assets: %d loaded in the background (%s), sprite sheet reloaded %d times during play (worst swap %.3f ms)\n",
+           assets.size(), assets.backend(), sheetReloads, worstSheetSwap * 1000.0);
+    printf("rewind: %d frames kept, %.1f KB per snapshot, %.1f MB buffer\n",
+           rewind.size(), sizeof(Snapshot) / 1024.0, rewind.bytes() / (1024.0 * 1024.0));
+    if (saveStatePath != nullptr) {
+        if (saveSnapshot(stateFile, frame, simHz, simTime, player, blocks, particles)) {
+            writeSnapshot(saveStatePath, stateFile);
+        }
+    }
+    delete overlay;
+    delete indexedBackground;
+    if (capture != nullptr) {
+        capture->close();
+        printf("capture: %ld frames written, %ld dropped, %.1f KB per frame, worst encode %.3f ms\n",
+               capture->written, capture->dropped, capture->bytes / 1024.0 / std::max(1L, capture->written),
+               capture->maxEncodeSeconds * 1000.0);
+    }
+    delete frameRing;
+    delete capture;
+    delete hudText;
+    delete hudFont;
+    munmap(fb_ptr, screensize);
+    close(fb_fd);
+    if (keyboard_fd != -1) {
+        close(keyboard_fd);
+    }
+
+    return replayer.mismatches == 0 && replayer.desyncs == 0 ? 0 : 2;
+}
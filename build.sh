@@ -1,10 +1,104 @@
-# 현재 디렉토리를 탐색해서 모든 cpp 파일을 컴파일하고 바이너리를 만든다.
+# 현재 디렉토리 파일을 탐색해서 모든 cpp 파일을 컴파일하고 바이너리를 만든다.
 # 바이너리는 output 디렉토리에 저장된다.
+#
+# 사용법: ./build.sh [release|relwithdebinfo|profile|debug|pgo|bench]
+#   release (기본)   -O2 -flto=auto
+#   relwithdebinfo   -O2 -g
+#   profile          -O2 -g -fno-omit-frame-pointer (perf record --call-graph fp 로 볼 때)
+#   debug            최적화 없이 -g
+#   pgo              release 빌드 뒤에 6_engine을 헤드리스 스크립트 실행으로 학습시켜 다시 빌드한다.
+#   bench            pgo 빌드 뒤에 6_engine 바이너리마다 같은 스크립트 실행의 평균 프레임 시간을 비교한다.
+#
+# 모든 바이너리는 기준 x86-64로 만들고, 6_engine은 AVX2(x86-64-v3) 변형 6_engine_avx2도 만든다.
+# engine/*.h는 6_engine.cpp가 include하는 부분이므로 따로 컴파일하지 않는다.
+
+set -e
+cd "$(dirname "$0")"
+
+CONFIG=${1:-release}
+BASELINE="-march=x86-64"
+AVX2="-march=x86-64-v3"
+# PGO 학습과 벤치마크에 쓰는 게임 루프 실행 (키보드 대신 봇 입력, 쉬지 않고 진행)
+# 기본 화면은 바뀐 영역만 그려서 너무 가벼우므로 인덱스 배경, 오버레이 합성, HUD, 디버그 도형까지 켠다.
+SCRIPT_ARGS="--headless --script 1200 --palette --overlay --hud --debug --threads $(nproc)"
+BENCH_RUNS=3
+
+case $CONFIG in
+    release|pgo|bench) FLAGS="-O2 -flto=auto" ;;
+    relwithdebinfo) FLAGS="-O2 -g" ;;
+    profile) FLAGS="-O2 -g -fno-omit-frame-pointer" ;;
+    debug) FLAGS="-O0 -g" ;;
+    *)
+        echo "unknown configuration: $CONFIG"
+        exit 1
+        ;;
+esac
 
 mkdir -p output
 for file in $(find . -name "*.cpp"); do
-    echo "Building $file"
-    g++ $file -o output/$(basename $file .cpp)
+    name=$(basename $file .cpp)
+    echo "Building $file ($CONFIG)"
+    g++ $FLAGS $BASELINE $file -o output/$name
+    if [ $name = 6_engine ]; then
+        g++ $FLAGS $AVX2 $file -o output/${name}_avx2
+    fi
 done
 
-cp *.bmp output/
\ No newline at end of file
+cp *.bmp *.atlas output/
+
+if [ $CONFIG = release ] || [ $CONFIG = relwithdebinfo ] || [ $CONFIG = profile ] || [ $CONFIG = debug ]; then
+    exit 0
+fi
+
+# CPU가 AVX2를 지원하지 않으면 AVX2 변형은 학습하거나 실행할 수 없다.
+VARIANTS="6_engine:$BASELINE"
+if grep -q avx2 /proc/cpuinfo; then
+    VARIANTS="$VARIANTS 6_engine_avx2:$AVX2"
+fi
+
+# 프로필은 오브젝트 파일 이름을 따라 저장되므로 학습과 재빌드 모두 같은 경로로 오브젝트를 만든다.
+for variant in $VARIANTS; do
+    name=${variant%%:*}
+    isa=${variant#*:}
+    dir=output/pgo-$name
+    rm -rf $dir
+    mkdir -p $dir
+    echo "Training $name"
+    g++ $FLAGS $isa -fprofile-generate -fprofile-update=atomic -c 6_engine.cpp -o $dir/6_engine.o
+    g++ $FLAGS $isa -fprofile-generate -fprofile-update=atomic $dir/6_engine.o -o $dir/train
+    (cd output && ./pgo-$name/train $SCRIPT_ARGS > /dev/null)
+    echo "Building ${name}_pgo"
+    g++ $FLAGS $isa -fprofile-use -fprofile-correction -c 6_engine.cpp -o $dir/6_engine.o
+    g++ $FLAGS $isa $dir/6_engine.o -o output/${name}_pgo
+done
+
+if [ $CONFIG = pgo ]; then
+    exit 0
+fi
+
+# 바이너리마다 BENCH_RUNS번 돌려 가장 짧은 평균 프레임 시간을 쓴다.
+best_frame() {
+    local best=""
+    for run in $(seq $BENCH_RUNS); do
+        local ms=$(cd output && ./$1 $SCRIPT_ARGS | sed -n 's/.*avg frame = \([0-9.]*\) ms.*/\1/p')
+        if [ -z "$best" ] || awk "BEGIN { exit !($ms < $best) }"; then
+            best=$ms
+        fi
+    done
+    echo $best
+}
+
+echo "Benchmark: $SCRIPT_ARGS (best of $BENCH_RUNS)"
+base=$(best_frame 6_engine)
+for variant in $VARIANTS; do
+    name=${variant%%:*}
+    for binary in $name ${name}_pgo; do
+        if [ $binary = 6_engine ]; then
+            ms=$base
+        else
+            ms=$(best_frame $binary)
+        fi
+        awk -v b=$binary -v ms=$ms -v base=$base \
+            'BEGIN { printf "  %-20s %7.3f ms per frame  x%.2f\n", b, ms, base / ms }'
+    done
+done
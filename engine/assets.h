@@ -0,0 +1,436 @@
+// 백그라운드 에셋 스트리밍: io_uring 읽기 링(IoRing)과 디코드 스레드(AssetLoader)
+// 6_engine.cpp의 Atlas 정의 바로 뒤에서 include되며, 앞쪽의 Image/countedAlloc 등을 그대로 씁니다.
+#pragma once
+
+#include <linux/io_uring.h>
+
+// io_uring 시스템 호출 (liburing 없이 커널 헤더만 씁니다)
+int ioUringSetup(unsigned entries, io_uring_params * params) {
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0);
+}
+
+// 읽기 요청만 쓰는 작은 io_uring
+// 한 스레드(AssetLoader의 I/O 스레드)만 씁니다. 커널과 나누는 head/tail은 acquire/release로 읽고 씁니다.
+class IoRing {
+private:
+    int fd = -1;
+    uint8_t * sqMap = (uint8_t*)MAP_FAILED;
+    uint8_t * cqMap = (uint8_t*)MAP_FAILED;
+    size_t sqMapSize = 0, cqMapSize = 0;
+    io_uring_sqe * sqes = (io_uring_sqe*)MAP_FAILED;
+    size_t sqesSize = 0;
+    unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+    unsigned *cqHead, *cqTail, *cqMask;
+    io_uring_cqe * cqes;
+    unsigned entries = 0;
+    unsigned unsubmitted = 0;   // 채웠지만 아직 커널에 넘기지 않은 요청 수
+
+public:
+    ~IoRing() {
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqesSize);
+        }
+        if (cqMap != MAP_FAILED && cqMap != sqMap) {
+            munmap(cqMap, cqMapSize);
+        }
+        if (sqMap != MAP_FAILED) {
+            munmap(sqMap, sqMapSize);
+        }
+        if (fd != -1) {
+            close(fd);
+        }
+    }
+
+    // 커널이 io_uring을 막아 두었으면 false
+    bool open(unsigned count) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        fd = ioUringSetup(count, &params);
+        if (fd < 0) {
+            fd = -1;
+            return false;
+        }
+        sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) {
+            sqMapSize = cqMapSize = std::max(sqMapSize, cqMapSize);
+        }
+        sqMap = (uint8_t*)mmap(nullptr, sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqMap == MAP_FAILED) {
+            return false;
+        }
+        cqMap = single ? sqMap : (uint8_t*)mmap(nullptr, cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                                 fd, IORING_OFF_CQ_RING);
+        if (cqMap == MAP_FAILED) {
+            return false;
+        }
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = (io_uring_sqe*)mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            return false;
+        }
+        sqHead = (unsigned*)(sqMap + params.sq_off.head);
+        sqTail = (unsigned*)(sqMap + params.sq_off.tail);
+        sqMask = (unsigned*)(sqMap + params.sq_off.ring_mask);
+        sqArray = (unsigned*)(sqMap + params.sq_off.array);
+        cqHead = (unsigned*)(cqMap + params.cq_off.head);
+        cqTail = (unsigned*)(cqMap + params.cq_off.tail);
+        cqMask = (unsigned*)(cqMap + params.cq_off.ring_mask);
+        cqes = (io_uring_cqe*)(cqMap + params.cq_off.cqes);
+        entries = params.sq_entries;
+        return true;
+    }
+
+    unsigned capacity() const { return entries; }
+
+    // 읽기 요청을 채워 둡니다. 커널에는 waitCompletion에서 한꺼번에 넘깁니다.
+    bool queueRead(int file, void * buffer, unsigned length, uint64_t offset, uint64_t userData) {
+        unsigned tail = *sqTail;
+        if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= entries) {
+            return false;
+        }
+        unsigned index = tail & *sqMask;
+        io_uring_sqe &sqe = sqes[index];
+        memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READ;
+        sqe.fd = file;
+        sqe.addr = (uint64_t)(uintptr_t)buffer;
+        sqe.len = length;
+        sqe.off = offset;
+        sqe.user_data = userData;
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        unsubmitted++;
+        return true;
+    }
+
+    // 쌓인 요청을 넘기고 완료 하나를 꺼냅니다. 완료가 없으면 올 때까지 잠듭니다.
+    bool waitCompletion(uint64_t &userData, int &result) {
+        while (true) {
+            unsigned head = *cqHead;
+            if (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+                const io_uring_cqe &cqe = cqes[head & *cqMask];
+                userData = cqe.user_data;
+                result = cqe.res;
+                __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+            int submitted = ioUringEnter(fd, unsubmitted, 1, IORING_ENTER_GETEVENTS);
+            if (submitted < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            unsubmitted -= std::min(unsubmitted, (unsigned)submitted);
+        }
+    }
+};
+
+// 에셋(BMP 이미지) 백그라운드 로딩
+// 렌더 스레드는 request()로 요청만 하고, 프레임마다 state()가 ASSET_READY가 된 것을 take()로 받아 갑니다.
+// 파일 읽기는 io_uring을 쓰는 I/O 스레드 하나가 맡고, 변환(Image::decode)은 변환 스레드들이 합니다.
+// io_uring을 쓸 수 없으면(--asset-io threads, 커널 설정 등) 변환 스레드가 pread로 직접 읽습니다.
+// 로딩 스레드는 우선순위를 낮춰서 CPU가 적을 때도 렌더 스레드를 밀어내지 않게 합니다.
+enum AssetIo { ASSET_IO_AUTO, ASSET_IO_URING, ASSET_IO_THREADS };
+enum AssetState { ASSET_QUEUED, ASSET_DECODING, ASSET_READY, ASSET_FAILED };
+const unsigned ASSET_RING_ENTRIES = 16;
+const int ASSET_DECODE_THREADS = 2;
+const int ASSET_THREAD_NICE = 10;
+const int ASSET_PATH_LENGTH = 256;
+const int ASSET_RELOAD_FRAMES = 60;     // 플레이 중 스프라이트 시트가 바뀌었는지 확인하는 간격
+
+class AssetLoader {
+private:
+    struct Asset {
+        char path[ASSET_PATH_LENGTH];
+        int fd = -1;
+        uint8_t * file = nullptr;
+        size_t size = 0;
+        size_t done = 0;
+        Image * image = nullptr;
+        bool reading = false;   // io_uring에 읽기가 걸려 있음 (I/O 스레드 전용)
+        std::atomic<int> state{ASSET_QUEUED};
+    };
+    Asset assets[MAX_ASSETS];
+    int assetCount = 0;
+    IoRing ring;
+    bool ringActive = false;
+    std::thread ioThread;
+    std::vector<std::thread> decoders;
+    std::mutex mutex;
+    std::condition_variable wake;
+    // 에셋은 각 큐에 한 번씩만 들어가므로 인덱스가 MAX_ASSETS를 넘지 않습니다.
+    int requests[MAX_ASSETS];
+    int requestHead = 0, requestTail = 0;
+    int decodes[MAX_ASSETS];
+    int decodeHead = 0, decodeTail = 0;
+    bool stopping = false;
+    bool ioFailed = false;  // I/O 스레드가 멈춤. 이후 요청은 바로 실패합니다.
+
+    static void lowerPriority() {
+        setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), ASSET_THREAD_NICE);
+    }
+
+    bool openFile(Asset &asset) {
+        asset.fd = open(asset.path, O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (asset.fd == -1 || fstat(asset.fd, &st) == -1) {
+            std::cerr << "Error: cannot open image file " << asset.path << "." << std::endl;
+            return false;
+        }
+        asset.size = st.st_size;
+        asset.done = 0;
+        asset.file = new uint8_t[asset.size + 1];
+        return true;
+    }
+
+    void closeFile(Asset &asset) {
+        if (asset.fd != -1) {
+            close(asset.fd);
+            asset.fd = -1;
+        }
+    }
+
+    void fail(Asset &asset) {
+        closeFile(asset);
+        delete[] asset.file;
+        asset.file = nullptr;
+        asset.state.store(ASSET_FAILED, std::memory_order_release);
+    }
+
+    // io_uring이 없을 때 변환 스레드가 직접 읽습니다.
+    bool readFile(Asset &asset) {
+        if (!openFile(asset)) {
+            return false;
+        }
+        while (asset.done < asset.size) {
+            ssize_t got = pread(asset.fd, asset.file + asset.done, asset.size - asset.done, asset.done);
+            if (got <= 0) {
+                if (got == -1 && errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            asset.done += got;
+        }
+        closeFile(asset);
+        return true;
+    }
+
+    // I/O 스레드가 더 진행할 수 없을 때, 읽는 중이거나 아직 읽지 않은 에셋을 모두 실패로 돌려서
+    // wait()나 state()로 기다리는 쪽이 멈추지 않게 합니다.
+    // 걸려 있던 읽기는 커널이 아직 버퍼에 쓸 수 있으므로 버퍼는 해제하지 않고 버립니다.
+    void failOutstanding() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int i = 0; i < assetCount; ++i) {
+            Asset &asset = assets[i];
+            if (asset.reading) {
+                asset.reading = false;
+                asset.file = nullptr;
+                closeFile(asset);
+                asset.state.store(ASSET_FAILED, std::memory_order_release);
+            }
+        }
+        while (requestHead != requestTail) {
+            assets[requests[requestHead++]].state.store(ASSET_FAILED, std::memory_order_release);
+        }
+        ioFailed = true;
+    }
+
+    bool queueRemaining(int id) {
+        Asset &asset = assets[id];
+        unsigned length = (unsigned)std::min(asset.size - asset.done, (size_t)INT32_MAX);
+        return ring.queueRead(asset.fd, asset.file + asset.done, length, asset.done, id);
+    }
+
+    void ioLoop() {
+        lowerPriority();
+        unsigned inFlight = 0;
+        while (true) {
+            int id = -1;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (inFlight == 0) {
+                    wake.wait(lock, [&] { return stopping || requestHead != requestTail; });
+                    if (stopping) {
+                        return;
+                    }
+                }
+                if (!stopping && requestHead != requestTail && inFlight < ring.capacity()) {
+                    id = requests[requestHead++];
+                }
+            }
+            // 새 요청을 먼저 모두 채운 뒤에 한 번의 시스템 호출로 넘깁니다.
+            if (id != -1) {
+                Asset &asset = assets[id];
+                if (!openFile(asset) || !queueRemaining(id)) {
+                    fail(asset);
+                } else {
+                    asset.reading = true;
+                    inFlight++;
+                }
+                continue;
+            }
+            uint64_t userData;
+            int result;
+            if (!ring.waitCompletion(userData, result)) {
+                std::cerr << "Error: io_uring wait failed." << std::endl;
+                failOutstanding();
+                return;
+            }
+            inFlight--;
+            // 완료된 읽기는 더 이상 걸려 있지 않으므로 어느 경로로 가든 먼저 내립니다.
+            Asset &asset = assets[userData];
+            asset.reading = false;
+            if (result > 0) {
+                asset.done += result;
+            }
+            if (result > 0 && asset.done < asset.size) {
+                // 짧게 읽혔으면 나머지를 다시 요청합니다.
+                if (queueRemaining((int)userData)) {
+                    asset.reading = true;
+                    inFlight++;
+                } else {
+                    fail(asset);
+                }
+            } else if (result < 0 || asset.done != asset.size) {
+                fail(asset);
+            } else {
+                closeFile(asset);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    decodes[decodeTail++] = (int)userData;
+                }
+                wake.notify_all();
+            }
+        }
+    }
+
+    void decodeLoop() {
+        lowerPriority();
+        while (true) {
+            int id;
+            bool needsRead;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] {
+                    return stopping || decodeHead != decodeTail || (!ringActive && requestHead != requestTail);
+                });
+                if (stopping) {
+                    return;
+                }
+                needsRead = decodeHead == decodeTail;
+                id = needsRead ? requests[requestHead++] : decodes[decodeHead++];
+            }
+            Asset &asset = assets[id];
+            if (needsRead && !readFile(asset)) {
+                fail(asset);
+                continue;
+            }
+            asset.state.store(ASSET_DECODING, std::memory_order_relaxed);
+            Image * image = new Image();
+            bool decoded = image->decode(asset.file, asset.size, asset.path);
+            delete[] asset.file;
+            asset.file = nullptr;
+            if (!decoded) {
+                delete image;
+                asset.state.store(ASSET_FAILED, std::memory_order_release);
+                continue;
+            }
+            asset.image = image;
+            asset.state.store(ASSET_READY, std::memory_order_release);
+        }
+    }
+
+public:
+    ~AssetLoader() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (ioThread.joinable()) {
+            ioThread.join();
+        }
+        for (std::thread &thread : decoders) {
+            thread.join();
+        }
+        for (int i = 0; i < assetCount; ++i) {
+            closeFile(assets[i]);
+            delete[] assets[i].file;
+            delete assets[i].image;
+        }
+    }
+
+    bool start(AssetIo io, int decodeThreads) {
+        if (io != ASSET_IO_THREADS) {
+            ringActive = ring.open(ASSET_RING_ENTRIES);
+            if (!ringActive && io == ASSET_IO_URING) {
+                std::cerr << "Error: io_uring is not available." << std::endl;
+                return false;
+            }
+        }
+        if (ringActive) {
+            ioThread = std::thread(&AssetLoader::ioLoop, this);
+        }
+        for (int i = 0; i < std::max(1, decodeThreads); ++i) {
+            decoders.emplace_back(&AssetLoader::decodeLoop, this);
+        }
+        return true;
+    }
+
+    const char * backend() const { return ringActive ? "io_uring" : "threads"; }
+    int size() const { return assetCount; }
+
+    // 에셋 번호를 돌려줍니다. 자리가 없으면 -1
+    int request(const char * path) {
+        if (assetCount >= MAX_ASSETS) {
+            return -1;
+        }
+        int id;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            id = assetCount++;
+            snprintf(assets[id].path, sizeof(assets[id].path), "%s", path);
+            if (ioFailed) {
+                assets[id].state.store(ASSET_FAILED, std::memory_order_release);
+                return id;
+            }
+            requests[requestTail++] = id;
+        }
+        wake.notify_all();
+        return id;
+    }
+
+    int state(int id) const {
+        return assets[id].state.load(std::memory_order_acquire);
+    }
+
+    // 준비된 이미지를 넘겨받습니다. 아직 안 됐거나 실패했거나 이미 받아 갔으면 nullptr
+    Image * take(int id) {
+        if (state(id) != ASSET_READY) {
+            return nullptr;
+        }
+        Image * image = assets[id].image;
+        assets[id].image = nullptr;
+        return image;
+    }
+
+    // 시작할 때처럼 기다려도 되는 곳에서 씁니다. 실패하면 nullptr
+    // I/O 스레드가 멈추면 남은 에셋은 모두 ASSET_FAILED가 되므로 여기서 계속 기다리지 않습니다.
+    Image * wait(int id) {
+        if (id < 0) {
+            return nullptr;
+        }
+        while (state(id) < ASSET_READY) {
+            usleep(500);
+        }
+        return take(id);
+    }
+};
@@ -0,0 +1,1329 @@
+// 벤치마크 (--bench name|all)와 BENCHMARKS 표
+// 6_engine.cpp에서 엔진 전체가 정의된 뒤, main 앞에 include됩니다.
+#pragma once
+
+// 벤치마크
+// 화면과 같은 크기의 메모리 버퍼에 대해 측정하므로 프레임버퍼 없이 실행됩니다.
+void benchBlend() {
+    fb_var_screeninfo vinfo;
+    fb_fix_screeninfo finfo;
+    makeHeadlessScreenInfo(vinfo, finfo);
+    Surface backBuffer(WIDTH, HEIGHT);
+    Surface frontBuffer(WIDTH, HEIGHT);
+    RenderTarget buffer = backBuffer.target();
+    RenderTarget fb = frontBuffer.target();
+    fillBackground(buffer, SKY_BLUE);
+
+    Image overlay(WIDTH, HEIGHT);
+    makeVignetteOverlay(overlay);
+
+    const int iterations = 200;
+    double start = nowSeconds();
+    for (int i = 0; i < iterations; ++i) {
+        for (int y = 0; y < HEIGHT; ++y) {
+            blendRowScalar(fb.row(y), overlay.pixels + y * WIDTH, WIDTH);
+        }
+    }
+    double scalar = (nowSeconds() - start) * 1000.0 / iterations;
+
+    start = nowSeconds();
+    for (int i = 0; i < iterations; ++i) {
+        for (int y = 0; y < HEIGHT; ++y) {
+            blendRow(fb.row(y), overlay.pixels + y * WIDTH, WIDTH);
+        }
+    }
+    double simd = (nowSeconds() - start) * 1000.0 / iterations;
+
+    Presenter presenter(PRESENT_COPY);
+    start = nowSeconds();
+    for (int i = 0; i < iterations; ++i) {
+        updateScreenWithOverlay(fb, buffer, overlay, presenter);
+        presenter.endFrame();
+    }
+    double present = (nowSeconds() - start) * 1000.0 / iterations;
+
+    printf("blend %dx%d %dbpp: scalar %.3f ms, simd %.3f ms, present with overlay %.3f ms per frame\n",
+           WIDTH, HEIGHT, (int)sizeof(FIXEL_FORMAT) * 8, scalar, simd, present);
+}
+
+// 클립 스택과 사각형 그리기를 무작위로 돌려 픽셀 단위 참조 구현과 비교합니다.
+// 화면 크기 버퍼 둘레에 카나리아 바이트를 두어 화면이나 클립 밖으로 쓰는지도 확인합니다.
+// 그릴 때마다 그 영역을 참조와 비교하고, fullCheck번마다 화면 전체와 카나리아를 확인합니다.
+void benchClip() {
+    const int guard = 16;                   // 둘레 카나리아 픽셀 수
+    const int srcWidth = 96, srcHeight = 64;
+    const int iterations = 20000;
+    const int fullCheck = 256;
+    const uint8_t canary = 0xA5;
+
+    // 행 간격은 SIMD 폭의 배수가 아니게 잡아 행 끝 처리도 함께 봅니다.
+    fb_var_screeninfo vinfo;
+    fb_fix_screeninfo finfo;
+    makeHeadlessScreenInfo(vinfo, finfo);
+    vinfo.xoffset = guard;
+    vinfo.yoffset = guard;
+    finfo.line_length = (WIDTH + guard * 2 + 3) * sizeof(FIXEL_FORMAT);
+    const int stride = finfo.line_length;
+    const size_t bytes = (size_t)stride * (HEIGHT + guard * 2);
+    uint8_t* memory = new uint8_t[bytes];
+    FIXEL_FORMAT* reference = new FIXEL_FORMAT[WIDTH * HEIGHT];
+    FIXEL_FORMAT* keyed = new FIXEL_FORMAT[srcWidth * srcHeight];
+    uint32_t* premultiplied = new uint32_t[srcWidth * srcHeight];
+    RenderTarget target = makeRenderTarget(memory, vinfo, finfo);
+
+    unsigned long long seed = 12345;
+    auto random = [&seed](int range) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        return (int)((seed >> 16) % (unsigned long long)range);
+    };
+    auto randomPixel = [&]() {
+        return (FIXEL_FORMAT)(random(65536) | (sizeof(FIXEL_FORMAT) > 2 ? random(65536) << 16 : 0));
+    };
+    auto pixel = [&](int x, int y) -> FIXEL_FORMAT & {
+        return target.row(y)[x];
+    };
+
+    // 키 이미지는 1/4 정도를 투명(0)으로, 알파 이미지는 완전 투명/불투명/중간 알파를 섞습니다.
+    for (int i = 0; i < srcWidth * srcHeight; ++i) {
+        keyed[i] = random(4) == 0 ? 0 : randomPixel();
+        int kind = random(4);
+        uint32_t a = kind == 0 ? 0 : kind == 1 ? 255 : (uint32_t)random(256);
+        premultiplied[i] = (a << 24) | ((uint32_t)random(a + 1) << 16) | ((uint32_t)random(a + 1) << 8) | (uint32_t)random(a + 1);
+    }
+
+    memset(memory, canary, bytes);
+    for (int y = 0; y < HEIGHT; ++y) {
+        for (int x = 0; x < WIDTH; ++x) {
+            reference[y * WIDTH + x] = pixel(x, y) = randomPixel();
+        }
+    }
+
+    // 참조 클립은 ClipStack을 쓰지 않고 화면과 쌓인 사각형 모두에 들어가는지 직접 확인합니다.
+    ClipRect pushed[MAX_CLIP_DEPTH];
+    int depth = 0;
+    auto inside = [&](int x, int y) {
+        if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) {
+            return false;
+        }
+        for (int k = 0; k < depth; ++k) {
+            const ClipRect &r = pushed[k];
+            if (x < r.x0 || x >= r.x1 || y < r.y0 || y >= r.y1) {
+                return false;
+            }
+        }
+        return true;
+    };
+    auto countMismatches = [&](int x0, int y0, int x1, int y1) {
+        long count = 0;
+        for (int y = std::max(y0, 0); y < std::min(y1, HEIGHT); ++y) {
+            for (int x = std::max(x0, 0); x < std::min(x1, WIDTH); ++x) {
+                count += pixel(x, y) != reference[y * WIDTH + x];
+            }
+        }
+        return count;
+    };
+    // 화면 영역을 뺀 나머지 바이트가 모두 카나리아 값인지 확인합니다.
+    auto countCanaryHits = [&]() {
+        long count = 0;
+        for (int row = 0; row < HEIGHT + guard * 2; ++row) {
+            const uint8_t* line = memory + (size_t)row * stride;
+            bool interior = row >= guard && row < guard + HEIGHT;
+            for (int b = 0; b < stride; ++b) {
+                if (interior && b >= guard * (int)sizeof(FIXEL_FORMAT) && b < (guard + WIDTH) * (int)sizeof(FIXEL_FORMAT)) {
+                    continue;
+                }
+                count += line[b] != canary;
+            }
+        }
+        return count;
+    };
+
+    long mismatches = 0, canaryHits = 0, drawn = 0;
+    const char * opNames[] = {"fill", "blit", "blend"};
+    int ops[3] = {0, 0, 0};
+    double start = nowSeconds();
+    for (int it = 0; it < iterations && mismatches == 0 && canaryHits == 0; ++it) {
+        int action = random(8);
+        if (action == 0 && depth < MAX_CLIP_DEPTH - 1) {
+            int x = random(WIDTH + 40) - 20, y = random(HEIGHT + 40) - 20;
+            int w = random(WIDTH), h = random(HEIGHT);
+            target.clip.push(x, y, w, h);
+            pushed[depth++] = {x, y, x + w, y + h};
+            continue;
+        }
+        if (action == 1 && depth > 0) {
+            target.clip.pop();
+            depth--;
+            continue;
+        }
+
+        // 화면 밖으로 걸치거나 완전히 벗어나는 위치도 나오도록 여유를 둡니다.
+        int op = random(3);
+        int sx = random(srcWidth), sy = random(srcHeight);
+        int w = random(srcWidth - sx) + 1, h = random(srcHeight - sy) + 1;
+        int x = random(WIDTH + srcWidth * 2) - srcWidth, y = random(HEIGHT + srcHeight * 2) - srcHeight;
+        FIXEL_FORMAT color = random(8) == 0 ? 0 : randomPixel();
+        if (op == 0) {
+            fillRect(target, x, y, w, h, color);
+        } else if (op == 1) {
+            blitRectData(target, x, y, w, h, keyed + sy * srcWidth + sx, srcWidth);
+        } else {
+            blendRectData(target, x, y, w, h, premultiplied + sy * srcWidth + sx, srcWidth);
+        }
+        ops[op]++;
+
+        for (int j = 0; j < h; ++j) {
+            for (int i = 0; i < w; ++i) {
+                int px = x + i, py = y + j;
+                if (!inside(px, py)) {
+                    continue;
+                }
+                FIXEL_FORMAT &out = reference[py * WIDTH + px];
+                int index = (sy + j) * srcWidth + sx + i;
+                if (op == 0) {
+                    if (color != 0) {
+                        out = color;
+                    }
+                } else if (op == 1) {
+                    if (keyed[index] != 0) {
+                        out = keyed[index];
+                    }
+                } else {
+                    blendRowScalar(&out, premultiplied + index, 1);
+                }
+                drawn++;
+            }
+        }
+
+        // 그린 사각형보다 한 픽셀 넓게 봐야 경계 바깥에 쓴 것도 걸립니다.
+        mismatches += countMismatches(x - 1, y - 1, x + w + 1, y + h + 1);
+        if (it % fullCheck == fullCheck - 1 || it == iterations - 1) {
+            mismatches += countMismatches(0, 0, WIDTH, HEIGHT);
+            canaryHits += countCanaryHits();
+        }
+        if (mismatches != 0 || canaryHits != 0) {
+            printf("clip: first failure at iteration %d (%s %d,%d %dx%d, clip depth %d)\n",
+                   it, opNames[op], x, y, w, h, depth);
+        }
+    }
+    double elapsed = nowSeconds() - start;
+
+    printf("clip fuzz %dx%d: fill %d, blit %d, blend %d, %ld pixels drawn, %ld mismatches, %ld canary bytes overwritten, %.2f s (%s)\n",
+           WIDTH, HEIGHT, ops[0], ops[1], ops[2], drawn, mismatches, canaryHits, elapsed,
+           mismatches == 0 && canaryHits == 0 ? "ok" : "FAILED");
+
+    delete[] memory;
+    delete[] reference;
+    delete[] keyed;
+    delete[] premultiplied;
+}
+
+// 작은 사각형을 많이 그릴 때의 함수 호출 비용
+// RenderTarget 이전 방식의 fillRect: 화면 정보를 값으로 받아 호출마다 클립 영역과 행 주소를 다시 계산합니다.
+// --bench calls에서 비교하는 데만 씁니다.
+void fillRectScreenInfo(uint8_t* fb_ptr, fb_var_screeninfo vinfo, fb_fix_screeninfo finfo, int x, int y, int w, int h, FIXEL_FORMAT color) {
+    const ClipRect screen = {0, 0, (int)vinfo.xres, (int)vinfo.yres};
+    int srcX = 0, srcY = 0;
+    if (color == 0 || !clipRect(screen, x, y, w, h, srcX, srcY)) {
+        return;
+    }
+    for (int j = 0; j < h; ++j) {
+        long location = (x + vinfo.xoffset) * (vinfo.bits_per_pixel / 8) +
+                        (y + j + vinfo.yoffset) * finfo.line_length;
+        fillRow((FIXEL_FORMAT*)(fb_ptr + location), color, w);
+    }
+}
+
+void benchCalls() {
+    Surface backBuffer(WIDTH, HEIGHT);
+    RenderTarget buffer = backBuffer.target();
+    fb_var_screeninfo vinfo;
+    fb_fix_screeninfo finfo;
+    makeHeadlessScreenInfo(vinfo, finfo);
+    vinfo.xres = WIDTH;
+    vinfo.yres = HEIGHT;
+    finfo.line_length = buffer.stride;
+
+    // 두 방식 모두 함수 포인터로 불러서 인라인되지 않은 호출 비용을 비교합니다.
+    void (*volatile before)(uint8_t*, fb_var_screeninfo, fb_fix_screeninfo, int, int, int, int, FIXEL_FORMAT) = fillRectScreenInfo;
+    void (*volatile after)(RenderTarget &, int, int, int, int, FIXEL_FORMAT) = fillRect;
+
+    const int calls = 2000000;
+    double start = nowSeconds();
+    for (int i = 0; i < calls; ++i) {
+        before(buffer.base, vinfo, finfo, (i * 37) % 1200, (i * 11) % 700, 4, 4, 0x1234);
+    }
+    double screenInfo = nowSeconds() - start;
+
+    start = nowSeconds();
+    for (int i = 0; i < calls; ++i) {
+        after(buffer, (i * 37) % 1200, (i * 11) % 700, 4, 4, 0x1234);
+    }
+    double target = nowSeconds() - start;
+    printf("calls: fillRect 4x4 %.1f ns per call with screen info (before), %.1f ns per call with RenderTarget (after)\n",
+           screenInfo * 1e9 / calls, target * 1e9 / calls);
+}
+
+// 서피스 사이의 채우기/복사/투명색 복사 처리량
+void benchSurface() {
+    Surface src(WIDTH, HEIGHT);
+    Surface dst(WIDTH, HEIGHT);
+    RenderTarget srcTarget = src.target();
+    RenderTarget dstTarget = dst.target();
+    fillBackground(srcTarget, SKY_BLUE);
+    fillRect(srcTarget, 100, 100, 400, 300, 0);
+
+    const int iterations = 300;
+    double bytes = (double)WIDTH * HEIGHT * sizeof(FIXEL_FORMAT) * iterations;
+
+    double start = nowSeconds();
+    for (int i = 0; i < iterations; ++i) {
+        fillRect(dstTarget, 0, 0, WIDTH, HEIGHT, convertTo(BROWN));
+    }
+    double fill = nowSeconds() - start;
+
+    start = nowSeconds();
+    for (int i = 0; i < iterations; ++i) {
+        copyRect(dstTarget, 0, 0, srcTarget, 0, 0, WIDTH, HEIGHT);
+    }
+    double copy = nowSeconds() - start;
+
+    start = nowSeconds();
+    for (int i = 0; i < iterations; ++i) {
+        blitSurface(dstTarget, 0, 0, src);
+    }
+    double blit = nowSeconds() - start;
+
+    printf("surface %dx%d: fill %.2f GB/s, copy %.2f GB/s, keyed blit %.2f GB/s\n",
+           WIDTH, HEIGHT, bytes / fill / 1e9, bytes / copy / 1e9, bytes / blit / 1e9);
+}
+
+// 화면 전체를 내보내는 비용을 방식별로 비교합니다.
+// 매 프레임 20x20 사각형 하나가 움직이므로 델타 출력은 그 주변만 씁니다.
+void benchPresentTarget(const char * label, RenderTarget &fb, RenderTarget &buffer) {
+    const int iterations = 300;
+    const PresentMode modes[] = {PRESENT_COPY, PRESENT_STREAM, PRESENT_DELTA};
+    const char * names[] = {"copy", "stream", "delta"};
+    for (int m = 0; m < 3; ++m) {
+        Presenter presenter(modes[m]);
+        fillBackground(buffer, SKY_BLUE);
+        double start = nowSeconds();
+        for (int i = 0; i < iterations; ++i) {
+            int x = (i * 7) % (WIDTH - 20);
+            fillRect(buffer, x, HEIGHT / 2, 20, 20, convertTo(i % 2 == 0 ? RED : DARK_GREEN));
+            updateScreen(fb, buffer, presenter);
+            presenter.endFrame();
+        }
+        double elapsed = nowSeconds() - start;
+        printf("present %s %s: %.3f ms per frame, %.2f GB/s, %.1f KB written per frame\n",
+               label, names[m], elapsed * 1000.0 / iterations,
+               (double)WIDTH * HEIGHT * sizeof(FIXEL_FORMAT) * iterations / elapsed / 1e9,
+               (double)presenter.totalBytes / presenter.frames / 1024.0);
+    }
+}
+
+void benchPresent() {
+    Surface backBuffer(WIDTH, HEIGHT);
+    RenderTarget buffer = backBuffer.target();
+
+    // memfd로 만든 가짜 프레임버퍼
+    fb_var_screeninfo vinfo;
+    fb_fix_screeninfo finfo;
+    int fd = openHeadlessFramebuffer(vinfo, finfo);
+    if (fd != -1) {
+        long size = (long)vinfo.yres_virtual * finfo.line_length;
+        uint8_t* ptr = (uint8_t*)mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ptr != MAP_FAILED) {
+            RenderTarget fb = makeRenderTarget(ptr, vinfo, finfo);
+            benchPresentTarget("memfd", fb, buffer);
+            munmap(ptr, size);
+        }
+        close(fd);
+    }
+
+    // 실제 프레임버퍼가 있으면 함께 측정합니다.
+    fd = open("/dev/fb0", O_RDWR);
+    if (fd == -1) {
+        printf("present fb0: not available\n");
+        return;
+    }
+    if (ioctl(fd, FBIOGET_VSCREENINFO, &vinfo) == 0 && ioctl(fd, FBIOGET_FSCREENINFO, &finfo) == 0 &&
+        vinfo.bits_per_pixel == sizeof(FIXEL_FORMAT) * 8 && vinfo.xres >= (uint32_t)WIDTH && vinfo.yres >= (uint32_t)HEIGHT) {
+        long size = (long)vinfo.yres_virtual * finfo.line_length;
+        uint8_t* ptr = (uint8_t*)mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ptr != MAP_FAILED) {
+            RenderTarget fb = makeRenderTarget(ptr, vinfo, finfo);
+            benchPresentTarget("fb0", fb, buffer);
+            munmap(ptr, size);
+        }
+    } else {
+        printf("present fb0: format does not match FIXEL_FORMAT\n");
+    }
+    close(fd);
+}
+
+// 두께 10픽셀의 상자 위로 공을 떨어뜨려 스텝 길이별로 뚫고 지나가는 횟수를 셉니다.
+// 끝 위치만 겹치는지 보는 방식과 swept 충돌을 비교합니다.
+void benchPhysics() {
+    const Box floor = {0, toFixed(400), toFixed(WIDTH), toFixed(10)};
+    const int drops = 2000;
+    const int rates[] = {60, 30, 15, 10};
+    for (int hz : rates) {
+        const Fixed dt = FIXED_ONE * SIM_TICK_HZ / hz;
+        int discreteTunnels = 0;
+        int sweptTunnels = 0;
+        long steps = 0;
+        double sweptTime = 0.0;
+        for (int d = 0; d < drops; ++d) {
+            // 시작 높이와 속도를 조금씩 바꿉니다.
+            const Body start = {toFixed(100), toFixed(d % 300), toFixed(20), toFixed(20), 0, (Fixed)(d * 7919 % toFixed(20))};
+
+            Body body = start;
+            while (body.y < floor.y) {
+                body.vy += fixedMul(toFixed(GRAVITY), dt);
+                body.y += fixedMul(body.vy, dt);
+                if (body.y + body.h > floor.y && body.y < floor.y + floor.h) {
+                    break;
+                }
+            }
+            if (body.y >= floor.y + floor.h) {
+                discreteTunnels++;
+            }
+
+            body = start;
+            double t0 = nowSeconds();
+            while (body.y < floor.y) {
+                steps++;
+                if (stepBody(body, &floor, 1, dt, toFixed(GRAVITY), toFixed(BOUND_GRAVITY)) & (1u << TOP)) {
+                    break;
+                }
+            }
+            sweptTime += nowSeconds() - t0;
+            if (body.y >= floor.y) {
+                sweptTunnels++;
+            }
+        }
+        printf("physics %2d Hz: discrete %d/%d tunneled, swept %d/%d tunneled, %.1f ns per step\n",
+               hz, discreteTunnels, drops, sweptTunnels, drops, sweptTime * 1e9 / steps);
+    }
+}
+
+// 서로 부딪히는 물체를 100개에서 10만 개까지 늘리며 브로드 페이즈 비용을 잽니다.
+// 밀도는 일정하게 두고, 1만 개까지는 모든 쌍을 검사하는 방식과 시간과 쌍 수를 비교합니다.
+void benchBroadPhase() {
+    const int counts[] = {100, 1000, 10000, 100000};
+    const int steps = 20;
+    const int cellSize = 24;
+    for (int n : counts) {
+        int cells = 1;
+        while (cells * cells < n) {
+            cells++;
+        }
+        const Fixed side = toFixed(cells * cellSize);
+        const int maxPairs = n * 8;
+        Body* bodies = new Body[n];
+        Box* bounds = new Box[n];
+        CollisionPair* pairs = new CollisionPair[maxPairs];
+        BroadPhase broadPhase(n);
+
+        unsigned long long seed = 12345;
+        auto random = [&seed](int range) {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            return (int)((seed >> 16) % (unsigned long long)range);
+        };
+        for (int i = 0; i < n; ++i) {
+            bodies[i] = {random(side - toFixed(8)), random(side - toFixed(8)), toFixed(8), toFixed(8),
+                         random(toFixed(4)) - toFixed(2), random(toFixed(4)) - toFixed(2)};
+        }
+
+        auto fillBounds = [&]() {
+            for (int i = 0; i < n; ++i) {
+                bounds[i] = {bodies[i].x, bodies[i].y, bodies[i].w, bodies[i].h};
+            }
+        };
+        fillBounds();
+        double start = nowSeconds();
+        broadPhase.update(bounds, n);
+        double firstSort = nowSeconds() - start;
+
+        double broadTime = 0.0, narrowTime = 0.0;
+        long totalPairs = 0, totalSwaps = 0;
+        for (int s = 0; s < steps; ++s) {
+            for (int i = 0; i < n; ++i) {
+                Body &body = bodies[i];
+                body.x += body.vx;
+                body.y += body.vy;
+                if (body.x < 0 || body.x + body.w > side) {
+                    body.vx = -body.vx;
+                    body.x = std::max(0, std::min(body.x, side - body.w));
+                }
+                if (body.y < 0 || body.y + body.h > side) {
+                    body.vy = -body.vy;
+                    body.y = std::max(0, std::min(body.y, side - body.h));
+                }
+            }
+            fillBounds();
+
+            start = nowSeconds();
+            broadPhase.update(bounds, n);
+            int pairCount = broadPhase.findPairs(pairs, maxPairs);
+            broadTime += nowSeconds() - start;
+
+            start = nowSeconds();
+            for (int i = 0; i < pairCount; ++i) {
+                resolveOverlap(bodies[pairs[i].a], bodies[pairs[i].b]);
+            }
+            narrowTime += nowSeconds() - start;
+            totalPairs += pairCount;
+            totalSwaps += broadPhase.swaps;
+        }
+
+        printf("broadphase %6d bodies: first sort %.2f ms, update+sweep %.3f ms, narrow %.3f ms per step, %.0f pairs, %.0f swaps",
+               n, firstSort * 1000.0, broadTime * 1000.0 / steps, narrowTime * 1000.0 / steps,
+               (double)totalPairs / steps, (double)totalSwaps / steps);
+        if (n <= 10000) {
+            fillBounds();
+            broadPhase.update(bounds, n);
+            int sweepPairs = broadPhase.findPairs(pairs, maxPairs);
+            start = nowSeconds();
+            int brutePairs = 0;
+            for (int i = 0; i < n; ++i) {
+                for (int j = i + 1; j < n; ++j) {
+                    const Box &a = bounds[i], &b = bounds[j];
+                    if (a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h) {
+                        brutePairs++;
+                    }
+                }
+            }
+            double brute = nowSeconds() - start;
+            printf(", brute force %.3f ms (%s)", brute * 1000.0, brutePairs == sweepPairs ? "same pairs" : "PAIR MISMATCH");
+        }
+        printf("\n");
+
+        delete[] bodies;
+        delete[] bounds;
+        delete[] pairs;
+    }
+}
+
+// 물리 월드를 스레드 수별로 돌려 스텝 시간과 결과가 같은지 확인합니다.
+// 4x4 물체를 폭 30000 픽셀의 땅 위로 흩뿌려 떨어뜨립니다. 뒤쪽 스텝은 쌓인 물체끼리의 접촉이 대부분입니다.
+uint32_t bodiesChecksum(const PhysicsWorld &world) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < world.size(); ++i) {
+        const uint8_t* bytes = (const uint8_t*)&world.body(i);
+        for (size_t k = 0; k < sizeof(Body); ++k) {
+            hash = (hash ^ bytes[k]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+void benchParallelPhysics() {
+    const int counts[] = {10000, 100000, 200000};
+    const int width = 30000;
+    const int threadCounts[] = {1, 2, 4, 8};
+    printf("physics world: %u hardware threads\n", std::thread::hardware_concurrency());
+    const int steps = 60;
+    const Box ground = groundBox();
+    for (int n : counts) {
+        double serial = 0.0;
+        uint32_t expected = 0;
+        for (int threads : threadCounts) {
+            PhysicsWorld world(n);
+            world.setStatics(&ground, 1);
+            unsigned long long seed = 12345;
+            auto random = [&seed](int range) {
+                seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+                return (int)((seed >> 16) % (unsigned long long)range);
+            };
+            for (int i = 0; i < n; ++i) {
+                world.add({random(toFixed(width)), random(toFixed(GROUND_LEVEL - 4)), toFixed(4), toFixed(4),
+                           random(toFixed(4)) - toFixed(2), 0});
+            }
+
+            WorkerPool workers(threads);
+            long contacts = 0;
+            double start = nowSeconds();
+            for (int s = 0; s < steps; ++s) {
+                world.step(FIXED_ONE, workers);
+                contacts += world.contactsLastStep;
+            }
+            double perStep = (nowSeconds() - start) * 1000.0 / steps;
+            uint32_t checksum = bodiesChecksum(world);
+            if (threads == 1) {
+                serial = perStep;
+                expected = checksum;
+            }
+            printf("physics world %6d bodies, %d threads: %.3f ms per step (x%.2f), %.0f contacts, checksum %08x%s\n",
+                   n, threads, perStep, serial / perStep, (double)contacts / steps, checksum,
+                   checksum == expected ? "" : " DIFFERENT");
+        }
+    }
+}
+
+// 프레임 녹화: 게임 루프가 push에 쓰는 시간, 압축률, 버린 프레임 수
+// 프레임 사이를 interval만큼 쉬는 경우와 쉬지 않고 밀어 넣는 경우(녹화 스레드보다 빠름)를 잽니다.
+// alternating이면 짝수 열 픽셀만 매 프레임 바꿔 LITERAL(1) + SKIP(1)이 번갈아 나오는 최악의 프레임을 만듭니다.
+void benchCaptureRun(int frames, int intervalUs, bool alternating) {
+    const char * path = "/tmp/fbgame-bench.fbc";
+    Surface backBuffer(WIDTH, HEIGHT);
+    RenderTarget buffer = backBuffer.target();
+    fillBackground(buffer, SKY_BLUE);
+    fillGround(buffer, BROWN);
+    FrameCapture capture;
+    if (!capture.open(path, WIDTH, HEIGHT)) {
+        return;
+    }
+    double worst = 0.0, total = 0.0;
+    for (int i = 0; i < frames; ++i) {
+        if (alternating) {
+            FIXEL_FORMAT color = convertTo(i % 2 == 0 ? RED : DARK_GREEN);
+            for (int y = 0; y < HEIGHT; ++y) {
+                FIXEL_FORMAT* row = buffer.row(y);
+                for (int x = 0; x < WIDTH; x += 2) {
+                    row[x] = color;
+                }
+            }
+        } else {
+            // 게임처럼 작은 사각형 몇 개만 움직입니다.
+            fillRect(buffer, (i * 7) % (WIDTH - 20), GROUND_LEVEL - 20, 20, 20, convertTo(i % 2 == 0 ? RED : DARK_GREEN));
+        }
+        double start = nowSeconds();
+        capture.push(buffer, i);
+        double elapsed = nowSeconds() - start;
+        worst = std::max(worst, elapsed);
+        total += elapsed;
+        if (intervalUs > 0) {
+            usleep(intervalUs);
+        }
+    }
+    capture.close();
+    printf("capture %dx%d%s, %5d us apart: push %.3f ms avg, %.3f ms worst; %ld written, %ld dropped, %.1f KB per frame (%.1f%% of raw)\n",
+           WIDTH, HEIGHT, alternating ? " alternating" : "", intervalUs, total * 1000.0 / frames, worst * 1000.0, capture.written, capture.dropped,
+           capture.bytes / 1024.0 / std::max(1L, capture.written),
+           100.0 * capture.bytes / std::max(1L, capture.written) / ((double)WIDTH * HEIGHT * sizeof(FIXEL_FORMAT)));
+    unlink(path);
+}
+
+void benchCapture() {
+    benchCaptureRun(300, 4000, false);
+    benchCaptureRun(300, 0, false);
+    benchCaptureRun(60, 20000, true);
+
+    // 최악의 프레임이 deltaBound 안에 들어가고 그대로 풀리는지 확인합니다.
+    const int count = WIDTH * HEIGHT;
+    std::vector<FIXEL_FORMAT> prev(count), cur(count), decoded(count);
+    for (int i = 0; i < count; ++i) {
+        prev[i] = convertTo(SKY_BLUE);
+        cur[i] = i % 2 == 0 ? convertTo(i % 4 == 0 ? RED : DARK_GREEN) : prev[i];
+    }
+    std::vector<uint8_t> encoded(deltaBound(count));
+    size_t size = encodeDelta(cur.data(), prev.data(), count, encoded.data());
+    decoded = prev;
+    bool ok = size <= encoded.size() && decodeDelta(encoded.data(), size, decoded.data(), count) && decoded == cur;
+    printf("capture worst case: %zu bytes for %d pixels (bound %zu), round trip %s\n",
+           size, count, encoded.size(), ok ? "ok" : "FAILED");
+}
+
+// 에셋 스트리밍: 큰 스프라이트 시트 여러 장을 읽는 동안의 프레임 시간
+// io가 음수면 기존처럼 프레임 안에서 한 장씩 Image를 만들고, 아니면 AssetLoader에 한꺼번에 요청한 뒤
+// 프레임마다 준비된 것만 받아 갑니다. 프레임은 60 FPS 간격으로 쉬며, 쉬는 동안 로딩 스레드가 일합니다.
+void benchAssetsRun(const char * label, int io, const char * path, int count) {
+    const int frameMicros = 16667;
+    Surface backBuffer(WIDTH, HEIGHT);
+    RenderTarget buffer = backBuffer.target();
+    AssetLoader loader;
+    if (io >= 0 && !loader.start((AssetIo)io, ASSET_DECODE_THREADS)) {
+        printf("assets %-8s: not available\n", label);
+        return;
+    }
+    int ids[MAX_ASSETS];
+    Image * images[MAX_ASSETS] = {};
+    bool done[MAX_ASSETS] = {};
+    int loaded = 0, failed = 0, frames = 0;
+    double start = nowSeconds(), worst = 0.0, total = 0.0;
+    if (io >= 0) {
+        for (int i = 0; i < count; ++i) {
+            ids[i] = loader.request(path);
+        }
+    }
+    while (loaded + failed < count) {
+        double frameStart = nowSeconds();
+        fillBackground(buffer, SKY_BLUE);
+        fillGround(buffer, BROWN);
+        for (int i = 0; i < count; ++i) {
+            if (done[i] || (io >= 0 && loader.state(ids[i]) < ASSET_READY)) {
+                continue;
+            }
+            images[i] = io >= 0 ? loader.take(ids[i]) : new Image(path);
+            done[i] = true;
+            if (images[i] != nullptr && images[i]->data != nullptr) {
+                loaded++;
+            } else {
+                failed++;
+            }
+            if (io < 0) {
+                break;
+            }
+        }
+        double elapsed = nowSeconds() - frameStart;
+        worst = std::max(worst, elapsed);
+        total += elapsed;
+        frames++;
+        usleep(std::max(0, frameMicros - (int)(elapsed * 1e6)));
+    }
+    printf("assets %-8s: %d loads in %.3f s over %d frames, frame %.3f ms avg, %.3f ms worst%s\n",
+           label, loaded, nowSeconds() - start, frames, total * 1000.0 / frames, worst * 1000.0,
+           failed > 0 ? " (FAILED loads)" : "");
+    for (int i = 0; i < count; ++i) {
+        delete images[i];
+    }
+}
+
+// 스냅샷: 저장/복원 시간과 되감기 버퍼 크기
+// 중간에 저장한 스냅샷으로 되돌린 뒤 같은 봇 입력으로 다시 진행해서 끝 상태가 같은지도 확인합니다.
+void benchSnapshot() {
+    const int frames = 600, saveAt = 200, iterations = 1000;
+    Atlas atlas;
+    atlas.attach(new Image(20, 20), nullptr);
+    Animation animation;
+    animation.fromPrefix(atlas, "ball");
+    Player player(layoutX(100), GROUND_LEVEL, &atlas, animation);
+    Pool<Block, MAX_BLOCKS> blocks;
+    for (int i = 0; i < LEVEL_BLOCKS; i++) {
+        int x, y;
+        levelBlockPosition(i, x, y);
+        blocks.create(x, y, LEVEL_BLOCK_WIDTH, LEVEL_BLOCK_HEIGHT);
+    }
+    ParticleSystem particles(MAX_PARTICLES);
+    const FIXEL_FORMAT dustColor = convertTo(DUST_COLOR);
+    Fixed simTime = 0;
+    Box boxes[MAX_BLOCKS + 1];
+
+    // 게임 루프의 한 프레임에서 그리기만 뺀 것 (틱 주기는 SIM_TICK_HZ)
+    auto runFrames = [&](int from, int to) {
+        for (int frame = from; frame < to; ++frame) {
+            int boxCount = 0;
+            boxes[boxCount++] = groundBox();
+            blocks.forEach([&](Block &block) {
+                boxes[boxCount++] = block.box();
+            });
+            simTime += FIXED_ONE;
+            while (simTime >= FIXED_ONE) {
+                player.body.vx = toFixed(botInput(0, frame));
+                unsigned contacts = stepBody(player.body, boxes, boxCount, FIXED_ONE, toFixed(GRAVITY), toFixed(BOUND_GRAVITY));
+                if (contacts & (1u << TOP)) {
+                    player.land();
+                    particles.emit((player.body.x + player.body.w / 2) / (float)FIXED_ONE,
+                                   (player.body.y + player.body.h) / (float)FIXED_ONE - 1.0f, DUST_PER_BOUNCE, 3.0f, 30.0f, dustColor);
+                }
+                simTime -= FIXED_ONE;
+            }
+            player.syncFromBody();
+            particles.update();
+            player.squash = std::max(0, player.squash - 1);
+        }
+    };
+
+    Snapshot* middle = new Snapshot();
+    Snapshot* first = new Snapshot();
+    Snapshot* second = new Snapshot();
+    runFrames(0, saveAt);
+    saveSnapshot(*middle, saveAt, SIM_TICK_HZ, simTime, player, blocks, particles);
+    runFrames(saveAt, frames);
+    saveSnapshot(*first, frames, SIM_TICK_HZ, simTime, player, blocks, particles);
+    restoreSnapshot(*middle, simTime, player, blocks, particles);
+    runFrames(saveAt, frames);
+    saveSnapshot(*second, frames, SIM_TICK_HZ, simTime, player, blocks, particles);
+    const SnapshotParticles &a = first->particles, &b = second->particles;
+    size_t n = a.count;
+    bool same = memcmp(first, second, offsetof(Snapshot, particles)) == 0 && a.count == b.count && a.seed == b.seed &&
+                memcmp(a.x, b.x, n * sizeof(float)) == 0 && memcmp(a.y, b.y, n * sizeof(float)) == 0 &&
+                memcmp(a.vx, b.vx, n * sizeof(float)) == 0 && memcmp(a.vy, b.vy, n * sizeof(float)) == 0 &&
+                memcmp(a.life, b.life, n * sizeof(float)) == 0 && memcmp(a.color, b.color, n * sizeof(FIXEL_FORMAT)) == 0;
+
+    // 되감기처럼 매 프레임 버퍼에 저장하고, 되감을 때처럼 꺼내서 복원합니다.
+    RewindBuffer rewind(REWIND_FRAMES);
+    double start = nowSeconds();
+    for (int i = 0; i < iterations; ++i) {
+        saveSnapshot(rewind.push(), frames, SIM_TICK_HZ, simTime, player, blocks, particles);
+    }
+    double saveTime = (nowSeconds() - start) / iterations;
+    start = nowSeconds();
+    for (int i = 0; i < iterations; ++i) {
+        const Snapshot * previous = rewind.pop();
+        if (previous == nullptr) {
+            previous = middle;
+        }
+        restoreSnapshot(*previous, simTime, player, blocks, particles);
+    }
+    double restoreTime = (nowSeconds() - start) / iterations;
+    printf("snapshot %.1f KB (%d particles saved): save %.3f us, restore %.3f us; rewind %d frames = %.1f MB; "
+           "resimulated from frame %d: %s\n",
+           sizeof(Snapshot) / 1024.0, middle->particles.count, saveTime * 1e6, restoreTime * 1e6, REWIND_FRAMES,
+           rewind.bytes() / (1024.0 * 1024.0), saveAt, same ? "identical" : "DIFFERENT");
+    delete middle;
+    delete first;
+    delete second;
+}
+
+void benchAssets() {
+    const int count = 12;
+    const int size = 1024;
+    const char * path = "/tmp/fbgame-bench-sheet.bmp";
+    std::vector<FIXEL_FORMAT> sheet((size_t)size * size);
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            sheet[(size_t)y * size + x] = convertTo({(uint8_t)x, (uint8_t)y, (uint8_t)(x ^ y), 255});
+        }
+    }
+    if (!writeBmp(path, sheet.data(), size, size)) {
+        return;
+    }
+    benchAssetsRun("sync", -1, path, count);
+    benchAssetsRun("threads", ASSET_IO_THREADS, path, count);
+    benchAssetsRun("io_uring", ASSET_IO_URING, path, count);
+    unlink(path);
+}
+
+// 프레임 링 찢어짐 검사
+// 쓰는 스레드는 프레임마다 모든 픽셀을 같은 값으로 채워 공개하고, 읽는 쪽은 제자리에서 모든 픽셀이
+// 그 값인지 확인합니다. seqlock을 통과한 읽기에서 섞인 프레임이 나오면 안 됩니다.
+void benchFrameRing() {
+    const int width = 320, height = 180;
+    const double seconds = 1.0;
+    char name[64];
+    snprintf(name, sizeof(name), "/fbgame-bench-%d", (int)getpid());
+    FrameRingWriter writer;
+    if (!writer.open(name, width, height)) {
+        return;
+    }
+    FrameRingReader reader;
+    if (!reader.open(name)) {
+        return;
+    }
+
+    std::atomic<bool> stop(false);
+    std::thread producer([&]() {
+        Surface frameSurface(width, height);
+        RenderTarget target = frameSurface.target();
+        for (uint64_t frame = 0; !stop.load(std::memory_order_relaxed); ++frame) {
+            FIXEL_FORMAT value = (FIXEL_FORMAT)(frame * 40503u + 1);
+            for (int y = 0; y < height; ++y) {
+                fillRow(target.row(y), value, width);
+            }
+            writer.publish(target, frame, value);
+        }
+    });
+
+    long reads = 0, torn = 0, bad = 0;
+    bool consistent = true;
+    auto visit = [&](const RenderTarget &target, uint64_t, uint32_t checksum) {
+        consistent = true;
+        for (int y = 0; y < target.height && consistent; ++y) {
+            const FIXEL_FORMAT* row = target.row(y);
+            for (int x = 0; x < target.width; ++x) {
+                if (row[x] != (FIXEL_FORMAT)checksum) {
+                    consistent = false;
+                    break;
+                }
+            }
+        }
+        if (!consistent) {
+            torn++;
+        }
+    };
+    double start = nowSeconds();
+    while (nowSeconds() - start < seconds) {
+        uint64_t frame;
+        if (reader.readLatest(visit, frame)) {
+            reads++;
+            if (!consistent) {
+                bad++;
+            }
+        }
+    }
+    stop.store(true);
+    producer.join();
+    printf("frame ring %dx%d: %ld frames published, %ld reads, %ld retries, %ld torn frames caught, %ld torn frames accepted\n",
+           width, height, writer.published, reads, reader.retries, torn, bad);
+}
+
+// 봇 월드 일괄 진행: 월드 수와 스레드 수별 처리량
+// 앞쪽 월드 몇 개는 stepBody로 따로 돌린 결과와 같은지 확인합니다.
+void benchWorlds() {
+    const int counts[] = {4096, 65536, 262144};
+    const int threadCounts[] = {1, 2, 4, 8};
+    const int ticks = 240;
+    const int verified = 256;
+    Box level[LEVEL_BLOCKS + 1];
+    int levelCount = makeLevelBoxes(level);
+    const Body start = botStartBody();
+
+    // 기준: 월드 하나씩 모든 상자로 stepBody
+    Body reference[verified];
+    for (int i = 0; i < verified; ++i) {
+        reference[i] = start;
+        for (int tick = 0; tick < ticks; ++tick) {
+            reference[i].vx = toFixed(botInput(i, tick));
+            stepBody(reference[i], level, levelCount, FIXED_ONE, toFixed(GRAVITY), toFixed(BOUND_GRAVITY));
+        }
+    }
+
+    for (int n : counts) {
+        double serial = 0.0;
+        for (int threads : threadCounts) {
+            WorldBatch batch(n, level, levelCount, start);
+            WorkerPool workers(threads);
+            double elapsed = 0.0;
+            for (int tick = 0; tick < ticks; ++tick) {
+                if (tick % BOT_INPUT_TICKS == 0) {
+                    for (int i = 0; i < n; ++i) {
+                        batch.setInput(i, botInput(i, tick));
+                    }
+                }
+                double stepStart = nowSeconds();
+                batch.step(workers);
+                elapsed += nowSeconds() - stepStart;
+            }
+            int mismatches = 0;
+            for (int i = 0; i < std::min(n, verified); ++i) {
+                WorldBatch::State state = batch.state(i);
+                if (state.x != reference[i].x || state.y != reference[i].y || state.vy != reference[i].vy) {
+                    mismatches++;
+                }
+            }
+            double rate = (double)n * ticks / elapsed / 1e6;
+            if (threads == 1) {
+                serial = rate;
+            }
+            printf("worlds %6d, %d threads: %.1f M world-steps/s (x%.2f), %d/%d differ from stepBody\n",
+                   n, threads, rate, rate / serial, mismatches, std::min(n, verified));
+        }
+    }
+
+    // 상자를 MAX_BLOCKS + 1개 모두 채운 레벨: 멀리 떨어진 상자 뒤에 실제 레벨을 두어 땅이 마지막 번호가 되게 합니다.
+    Box full[MAX_BLOCKS + 1];
+    int fullCount = 0;
+    while (fullCount < MAX_BLOCKS + 1 - levelCount) {
+        full[fullCount] = {toFixed(-100000 - fullCount * 100), toFixed(-100000), toFixed(10), toFixed(10)};
+        fullCount++;
+    }
+    for (int k = levelCount - 1; k >= 0; --k) {
+        full[fullCount++] = level[k];
+    }
+    WorldBatch batch(verified, full, fullCount, start);
+    WorkerPool workers(1);
+    int mismatches = 0;
+    for (int tick = 0; tick < ticks; ++tick) {
+        if (tick % BOT_INPUT_TICKS == 0) {
+            for (int i = 0; i < verified; ++i) {
+                batch.setInput(i, botInput(i, tick));
+            }
+        }
+        batch.step(workers);
+    }
+    for (int i = 0; i < verified; ++i) {
+        Body body = start;
+        for (int tick = 0; tick < ticks; ++tick) {
+            body.vx = toFixed(botInput(i, tick));
+            stepBody(body, full, fullCount, FIXED_ONE, toFixed(GRAVITY), toFixed(BOUND_GRAVITY));
+        }
+        WorldBatch::State state = batch.state(i);
+        if (state.x != body.x || state.y != body.y || state.vy != body.vy) {
+            mismatches++;
+        }
+    }
+    printf("worlds with %d boxes: %d/%d differ from stepBody\n", fullCount, mismatches, verified);
+}
+
+// 파티클 100만 개를 계속 다시 뿌리면서 갱신과 그리기 시간을 잽니다 (60 FPS면 16.7 ms 안).
+void benchParticles() {
+    const int particleCount = 1000000;
+    const int frames = 60;
+    Surface backBuffer(WIDTH, HEIGHT);
+    RenderTarget buffer = backBuffer.target();
+    ParticleSystem particles(particleCount);
+    ParticleSystem reference(particleCount);    // 같은 파티클을 스칼라 갱신으로 진행합니다.
+    particles.gravity = reference.gravity = 0.05f;
+    const FIXEL_FORMAT dustColor = convertTo(DUST_COLOR);
+
+    double updateTime = 0.0, scalarTime = 0.0, renderTime = 0.0;
+    long live = 0;
+    bool same = true;
+    for (int frame = 0; frame < frames; ++frame) {
+        // 죽은 만큼 화면 곳곳에서 다시 뿌립니다.
+        int missing = particleCount - particles.size();
+        for (int k = 0; k < 64 && missing > 0; ++k) {
+            int n = std::min(missing, particleCount / 64 + 1);
+            particles.emit((float)(k * 97 % WIDTH), (float)(HEIGHT / 2 + k * 5), n, 6.0f, 120.0f, dustColor);
+            reference.emit((float)(k * 97 % WIDTH), (float)(HEIGHT / 2 + k * 5), n, 6.0f, 120.0f, dustColor);
+            missing -= n;
+        }
+
+        double start = nowSeconds();
+        reference.updateScalar();
+        scalarTime += nowSeconds() - start;
+
+        start = nowSeconds();
+        particles.update();
+        updateTime += nowSeconds() - start;
+
+        fillBackground(buffer, SKY_BLUE);
+        start = nowSeconds();
+        particles.render(buffer, 1);
+        renderTime += nowSeconds() - start;
+        live += particles.size();
+        same = same && particles.same(reference);
+    }
+    printf("particles %.0f live: update %.3f ms (scalar %.3f ms, %s), render %.3f ms, total %.3f ms per frame\n",
+           (double)live / frames, updateTime * 1000.0 / frames, scalarTime * 1000.0 / frames,
+           same ? "same particles" : "DIFFERENT", renderTime * 1000.0 / frames, (updateTime + renderTime) * 1000.0 / frames);
+}
+
+// 상태 표시 네 줄을 글자마다 그릴 때와 문자열 캐시로 그릴 때를 비교합니다.
+void benchText() {
+    const int iterations = 20000;
+    Surface backBuffer(WIDTH, HEIGHT);
+    RenderTarget buffer = backBuffer.target();
+    BitmapFont font(convertTo(HUD_COLOR), HUD_SCALE);
+    TextCache cache(font);
+    const char * lines[] = {"FRAME 12345", "FPS 59.9", "DUST 1024", "PRESENT 15.8 KB"};
+
+    double start = nowSeconds();
+    for (int i = 0; i < iterations; ++i) {
+        for (int l = 0; l < 4; ++l) {
+            font.draw(buffer, HUD_X, HUD_Y + l * 20, lines[l]);
+        }
+    }
+    double glyphs = (nowSeconds() - start) * 1e9 / (iterations * 4);
+
+    start = nowSeconds();
+    for (int i = 0; i < iterations; ++i) {
+        for (int l = 0; l < 4; ++l) {
+            cache.draw(buffer, HUD_X, HUD_Y + l * 20, lines[l]);
+        }
+    }
+    double cached = (nowSeconds() - start) * 1e9 / (iterations * 4);
+
+    printf("text scale %d: per glyph %.0f ns, cached run %.0f ns per string (%ld hits, %ld misses)\n",
+           HUD_SCALE, glyphs, cached, cache.hits, cache.misses);
+}
+
+// 인덱스 색상 서피스와 직접 색상 서피스의 메모리 크기와 처리량 비교
+void benchIndexed() {
+    const int iterations = 200;
+    const int spriteSize = 64;
+    const int spriteIterations = 20000;
+    #if defined(__AVX2__)
+    const char * path = "runs + avx2 gather";
+    #elif defined(__SSE2__)
+    const char * path = "runs + sse2 lut";
+    #else
+    const char * path = "scalar lut";
+    #endif
+
+    Surface backBuffer(WIDTH, HEIGHT);
+    RenderTarget buffer = backBuffer.target();
+    Surface direct(WIDTH, HEIGHT);
+    RenderTarget directTarget = direct.target();
+    IndexedSurface indexed(WIDTH, HEIGHT);
+    makeIndexedBackground(indexed);
+    drawIndexed(directTarget, 0, 0, indexed, false);
+
+    // 원 모양 스프라이트 (바깥은 투명)
+    Surface sprite(spriteSize, spriteSize);
+    IndexedSurface indexedSprite(spriteSize, spriteSize);
+    indexedSprite.palette.set(1, RED);
+    indexedSprite.palette.set(2, DARK_GREEN);
+    for (int y = 0; y < spriteSize; ++y) {
+        for (int x = 0; x < spriteSize; ++x) {
+            int dx = x - spriteSize / 2, dy = y - spriteSize / 2;
+            uint8_t index = dx * dx + dy * dy < spriteSize * spriteSize / 4 ? 1 + ((x ^ y) & 8 ? 1 : 0) : 0;
+            indexedSprite.row(y)[x] = index;
+            sprite.row(y)[x] = index != 0 ? indexedSprite.palette.colors[index] : 0;
+        }
+    }
+
+    printf("indexed footprint: screen %zu KB direct, %zu KB indexed; sprite %dx%d %zu B direct, %zu B indexed + palette\n",
+           (size_t)direct.stride * direct.height / 1024, indexed.bytes() / 1024, spriteSize, spriteSize,
+           (size_t)sprite.stride * sprite.height, (size_t)indexedSprite.stride * indexedSprite.height);
+
+    double start = nowSeconds();
+    for (int i = 0; i < iterations; ++i) {
+        copyRect(buffer, 0, 0, directTarget, 0, 0, WIDTH, HEIGHT);
+    }
+    double copy = (nowSeconds() - start) * 1000.0 / iterations;
+
+    start = nowSeconds();
+    for (int i = 0; i < iterations; ++i) {
+        drawIndexed(buffer, 0, 0, indexed, false);
+    }
+    double expand = (nowSeconds() - start) * 1000.0 / iterations;
+    printf("indexed screen copy: direct %.3f ms, indexed (%s) %.3f ms\n", copy, path, expand);
+
+    // 같은 인덱스가 이어지지 않는 최악의 경우 (모든 구간이 표 조회)
+    IndexedSurface noise(WIDTH, HEIGHT);
+    memcpy(noise.palette.colors, indexed.palette.colors, sizeof(noise.palette.colors));
+    memcpy(noise.palette.wide, indexed.palette.wide, sizeof(noise.palette.wide));
+    for (int y = 0; y < HEIGHT; ++y) {
+        for (int x = 0; x < WIDTH; ++x) {
+            noise.row(y)[x] = (uint8_t)((x * 7 + y * 13 + (x >> 3) * (y >> 2)) & 255);
+        }
+    }
+    start = nowSeconds();
+    for (int i = 0; i < iterations; ++i) {
+        drawIndexed(buffer, 0, 0, noise, false);
+    }
+    double noiseExpand = (nowSeconds() - start) * 1000.0 / iterations;
+    printf("indexed noise copy (no runs): indexed %.3f ms\n", noiseExpand);
+
+    start = nowSeconds();
+    for (int i = 0; i < spriteIterations; ++i) {
+        blitSurface(buffer, (i * 37) % (WIDTH - spriteSize), (i * 53) % (HEIGHT - spriteSize), sprite);
+    }
+    double keyed = (double)spriteSize * spriteSize * spriteIterations / (nowSeconds() - start) / 1e6;
+
+    start = nowSeconds();
+    for (int i = 0; i < spriteIterations; ++i) {
+        drawIndexed(buffer, (i * 37) % (WIDTH - spriteSize), (i * 53) % (HEIGHT - spriteSize), indexedSprite, true);
+    }
+    double indexedKeyed = (double)spriteSize * spriteSize * spriteIterations / (nowSeconds() - start) / 1e6;
+    printf("indexed sprite keyed blit: direct %.0f Mpixel/s, indexed %.0f Mpixel/s\n", keyed, indexedKeyed);
+
+    // 팔레트만 돌리고 화면 전체를 다시 내보내는 비용
+    fb_var_screeninfo vinfo;
+    fb_fix_screeninfo finfo;
+    int fd = openHeadlessFramebuffer(vinfo, finfo);
+    if (fd == -1) {
+        return;
+    }
+    long size = (long)vinfo.yres_virtual * finfo.line_length;
+    uint8_t* ptr = (uint8_t*)mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr != MAP_FAILED) {
+        RenderTarget fb = makeRenderTarget(ptr, vinfo, finfo);
+        Presenter presenter(PRESENT_STREAM);
+        start = nowSeconds();
+        for (int i = 0; i < iterations; ++i) {
+            updateScreen(fb, directTarget, presenter);
+            presenter.endFrame();
+        }
+        double directPresent = (nowSeconds() - start) * 1000.0 / iterations;
+        start = nowSeconds();
+        for (int i = 0; i < iterations; ++i) {
+            indexed.palette.cycle(PALETTE_SKY_FIRST, PALETTE_SKY_SHADES);
+            updateScreenIndexed(fb, indexed, presenter);
+            presenter.endFrame();
+        }
+        double indexedPresent = (nowSeconds() - start) * 1000.0 / iterations;
+        printf("indexed present: direct %.3f ms, palette cycle + indexed %.3f ms per frame\n", directPresent, indexedPresent);
+        munmap(ptr, size);
+    }
+    close(fd);
+}
+
+// 스팬 래스터라이저: 도형 하나를 그리는 데 걸리는 시간
+void benchRaster() {
+    const int iterations = 20000;
+    Surface backBuffer(WIDTH, HEIGHT);
+    RenderTarget buffer = backBuffer.target();
+    const FIXEL_FORMAT color = convertTo(RED);
+    Point star[10];
+    for (int i = 0; i < 10; ++i) {
+        float angle = i * 3.14159265f / 5;
+        float r = i % 2 == 0 ? 60.0f : 25.0f;
+        star[i] = {(int)(r * sinf(angle)), (int)(-r * cosf(angle))};
+    }
+
+    double start = nowSeconds();
+    for (int i = 0; i < iterations; ++i) {
+        int x = (i * 37) % WIDTH, y = (i * 53) % HEIGHT;
+        drawLine(buffer, x, y, x + 200 - (i % 400), y + 100 - (i % 200), color);
+    }
+    double line = (nowSeconds() - start) * 1e9 / iterations;
+
+    start = nowSeconds();
+    for (int i = 0; i < iterations; ++i) {
+        drawCircle(buffer, (i * 37) % WIDTH, (i * 53) % HEIGHT, 40, color);
+    }
+    double circle = (nowSeconds() - start) * 1e9 / iterations;
+
+    start = nowSeconds();
+    for (int i = 0; i < iterations; ++i) {
+        fillCircle(buffer, (i * 37) % WIDTH, (i * 53) % HEIGHT, 40, color);
+    }
+    double disc = (nowSeconds() - start) * 1e9 / iterations;
+
+    start = nowSeconds();
+    for (int i = 0; i < iterations; ++i) {
+        Point moved[10];
+        int x = (i * 37) % WIDTH, y = (i * 53) % HEIGHT;
+        for (int k = 0; k < 10; ++k) {
+            moved[k] = {star[k].x + x, star[k].y + y};
+        }
+        fillPolygon(buffer, moved, 10, color);
+    }
+    double polygon = (nowSeconds() - start) * 1e9 / iterations;
+
+    printf("raster: line ~200px %.0f ns, circle r40 %.0f ns, filled circle r40 %.0f ns, 10-point star %.0f ns\n",
+           line, circle, disc, polygon);
+}
+
+// 늘려 그리기/회전 그리기의 처리량 (Mpixel/s, 대상 픽셀 기준)
+// 0 투명색 복사와 알파 블렌딩 원본을 모두 잽니다. 1:1 복사(blitRectData)와 비교합니다.
+void benchScaled() {
+    const int size = 64;
+    const int iterations = 2000;
+    Surface backBuffer(WIDTH, HEIGHT);
+    RenderTarget buffer = backBuffer.target();
+    Image image(size, size);
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            bool inside = (x - size / 2) * (x - size / 2) + (y - size / 2) * (y - size / 2) < size * size / 4;
+            image.data[y * size + x] = inside ? convertTo((x ^ y) & 8 ? RED : DARK_GREEN) : 0;
+            image.pixels[y * size + x] = inside ? 0xC0600000u | (uint32_t)(x * 2) : 0;
+        }
+    }
+    const SpriteView keyed = {image.data, nullptr, size, size, size};
+    const SpriteView blended = {image.data, image.pixels, size, size, size};
+
+    double start = nowSeconds();
+    for (int i = 0; i < iterations; ++i) {
+        blitRectData(buffer, (i * 37) % (WIDTH - size), (i * 53) % (HEIGHT - size), size, size, image.data, size);
+    }
+    printf("scaled 1:1 blit: %.0f Mpixel/s\n", (double)size * size * iterations / (nowSeconds() - start) / 1e6);
+
+    const float factors[] = {0.5f, 1.0f, 1.5f, 2.0f, 3.0f, 4.0f};
+    for (float factor : factors) {
+        int w = (int)(size * factor);
+        double rates[4];
+        for (int k = 0; k < 4; ++k) {
+            const SpriteView &src = k % 2 == 0 ? keyed : blended;
+            const AffineMap rotate = makeAffine(0.5f, factor, factor);
+            long long pixels = 0;
+            start = nowSeconds();
+            for (int i = 0; i < iterations; ++i) {
+                int x = (i * 37) % (WIDTH - w);
+                int y = (i * 53) % (HEIGHT - w);
+                if (k < 2) {
+                    blitScaled(buffer, x, y, w, w, src);
+                } else {
+                    blitAffine(buffer, x + w / 2, y + w / 2, src, rotate);
+                }
+                pixels += (long long)w * w;
+            }
+            rates[k] = pixels / (nowSeconds() - start) / 1e6;
+        }
+        printf("scaled x%.1f (%dx%d): keyed %.0f, blend %.0f, rotated keyed %.0f, rotated blend %.0f Mpixel/s\n",
+               factor, w, w, rates[0], rates[1], rates[2], rates[3]);
+    }
+}
+
+// 내부 해상도를 줄였을 때 그리는 비용과 늘려서 내보내는 비용을 함께 잽니다.
+// 늘리기 커널은 스칼라 복제와도 비교합니다.
+void benchUpscale() {
+    const int iterations = 200;
+    fb_var_screeninfo vinfo;
+    fb_fix_screeninfo finfo;
+    int fd = openHeadlessFramebuffer(vinfo, finfo);
+    if (fd == -1) {
+        return;
+    }
+    long size = (long)vinfo.yres_virtual * finfo.line_length;
+    uint8_t* ptr = (uint8_t*)mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+        close(fd);
+        return;
+    }
+    RenderTarget fb = makeRenderTarget(ptr, vinfo, finfo);
+
+    const int scales[] = {1, 2, 4};
+    for (int scale : scales) {
+        setRenderSize(fb.width / scale, fb.height / scale);
+        Surface backBuffer(WIDTH, HEIGHT);
+        RenderTarget buffer = backBuffer.target();
+        Presenter presenter(PRESENT_STREAM, fb.width, fb.height, scale);
+
+        double start = nowSeconds();
+        for (int i = 0; i < iterations; ++i) {
+            fillBackground(buffer, SKY_BLUE);
+            fillGround(buffer, DARK_GREEN);
+        }
+        double draw = (nowSeconds() - start) * 1000.0 / iterations;
+
+        start = nowSeconds();
+        for (int i = 0; i < iterations; ++i) {
+            updateScreen(fb, buffer, presenter);
+            presenter.endFrame();
+        }
+        double present = (nowSeconds() - start) * 1000.0 / iterations;
+        printf("upscale x%d (%dx%d): draw %.3f ms, present %.3f ms per frame\n",
+               scale, WIDTH, HEIGHT, draw, present);
+    }
+    setRenderSize(DEFAULT_SCREEN_WIDTH, DEFAULT_SCREEN_HEIGHT);
+
+    // 한 행 늘리기: SIMD와 스칼라
+    const int rows = iterations * 100;
+    const int count = DEFAULT_SCREEN_WIDTH / 4;
+    FIXEL_FORMAT* src = (FIXEL_FORMAT*)countedAlloc(DEFAULT_SCREEN_WIDTH * sizeof(FIXEL_FORMAT), SURFACE_ALIGN);
+    FIXEL_FORMAT* dst = (FIXEL_FORMAT*)countedAlloc(DEFAULT_SCREEN_WIDTH * sizeof(FIXEL_FORMAT), SURFACE_ALIGN);
+    for (int i = 0; i < DEFAULT_SCREEN_WIDTH; ++i) {
+        src[i] = (FIXEL_FORMAT)(i * 2654435761u);
+    }
+    const int factors[] = {2, 4};
+    for (int factor : factors) {
+        double start = nowSeconds();
+        for (int r = 0; r < rows; ++r) {
+            upscaleRow(dst, src, count, factor);
+        }
+        double simd = (nowSeconds() - start) * 1e9 / rows;
+        volatile FIXEL_FORMAT sink = dst[count - 1];
+
+        start = nowSeconds();
+        for (int r = 0; r < rows; ++r) {
+            volatile FIXEL_FORMAT* out = dst;
+            for (int i = 0; i < count; ++i) {
+                for (int k = 0; k < factor; ++k) {
+                    out[i * factor + k] = src[i];
+                }
+            }
+        }
+        double scalar = (nowSeconds() - start) * 1e9 / rows;
+        sink = dst[count - 1];
+        (void)sink;
+        printf("upscale row x%d (%d px): simd %.0f ns, scalar %.0f ns\n", factor, count, simd, scalar);
+    }
+    countedFree(src);
+    countedFree(dst);
+
+    munmap(ptr, size);
+    close(fd);
+}
+
+struct Benchmark {
+    const char * name;
+    void (*run)();
+};
+
+const Benchmark BENCHMARKS[] = {
+    {"blend", benchBlend},
+    {"clip", benchClip},
+    {"calls", benchCalls},
+    {"surface", benchSurface},
+    {"present", benchPresent},
+    {"physics", benchPhysics},
+    {"broadphase", benchBroadPhase},
+    {"parallel", benchParallelPhysics},
+    {"worlds", benchWorlds},
+    {"shm", benchFrameRing},
+    {"capture", benchCapture},
+    {"assets", benchAssets},
+    {"snapshot", benchSnapshot},
+    {"particles", benchParticles},
+    {"text", benchText},
+    {"upscale", benchUpscale},
+    {"scaled", benchScaled},
+    {"raster", benchRaster},
+    {"indexed", benchIndexed},
+};
@@ -0,0 +1,288 @@
+// 비동기 프레임 녹화 (--capture, --capture-play): 앞 프레임과의 차이 압축, 녹화 스레드, BMP 저장
+// 6_engine.cpp에서 nowSeconds 등이 정의된 뒤에 include됩니다.
+#pragma once
+
+// 비동기 프레임 녹화 (--capture file)
+// 게임 루프는 끝난 프레임을 미리 잡아 둔 칸에 복사해 큐에 넣기만 하고, 압축과 파일 쓰기는 녹화 스레드가 합니다.
+// 큐는 생산자 하나/소비자 하나인 고정 크기 링이며, 가득 차 있으면 기다리지 않고 그 프레임을 버립니다.
+// 파일: [CaptureHeader]([CaptureFrameHeader][압축 데이터])...
+// 압축은 바로 앞에 기록한 프레임과의 차이를 제어 워드 단위로 적습니다 (위 2비트 종류, 아래 14비트 길이).
+//   SKIP n: 앞 프레임과 같은 픽셀 n개
+//   RUN n: 같은 값 n개 (값 하나가 뒤따름)
+//   LITERAL n: 픽셀 n개가 그대로 뒤따름
+const char CAPTURE_MAGIC[4] = {'F', 'B', 'C', 'P'};
+const uint16_t CAPTURE_VERSION = 1;
+const int CAPTURE_QUEUE_SLOTS = 8;
+const uint16_t CAPTURE_SKIP = 0;
+const uint16_t CAPTURE_RUN = 1;
+const uint16_t CAPTURE_LITERAL = 2;
+const int CAPTURE_MAX_COUNT = 0x3FFF;
+// 이보다 짧게 반복되는 값은 LITERAL에 넣습니다.
+const int CAPTURE_MIN_RUN = 3;
+
+struct CaptureHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t pixelBits;
+    int32_t width, height;
+};
+
+struct CaptureFrameHeader {
+    uint32_t frame;
+    uint32_t checksum;  // frameChecksum 값 (녹화 스레드가 계산)
+    uint32_t bytes;     // 뒤따르는 압축 데이터 크기
+};
+
+// 최악의 경우 압축 데이터 크기 (녹화 스레드와 --capture-play가 같이 씁니다)
+// 바뀐 픽셀과 그대로인 픽셀이 번갈아 나오면 LITERAL(1) + SKIP(1)이 픽셀 두 개마다 생기므로
+// 픽셀마다 값 하나와 제어 워드 하나를 잡습니다. 어떤 토큰도 픽셀당 이보다 많이 쓰지 않습니다.
+size_t deltaBound(int count) {
+    return (size_t)count * (sizeof(FIXEL_FORMAT) + sizeof(uint16_t));
+}
+
+inline uint8_t* putControl(uint8_t* out, uint16_t type, int count) {
+    uint16_t control = (uint16_t)((type << 14) | count);
+    memcpy(out, &control, sizeof(control));
+    return out + sizeof(control);
+}
+
+// cur를 prev에 대한 차이로 압축합니다. 쓴 바이트 수를 돌려줍니다.
+size_t encodeDelta(const FIXEL_FORMAT* cur, const FIXEL_FORMAT* prev, int count, uint8_t* out) {
+    uint8_t* start = out;
+    int i = 0;
+    while (i < count) {
+        // 바뀌지 않은 구간
+        int j = i;
+        while (j < count && j - i < CAPTURE_MAX_COUNT && cur[j] == prev[j]) {
+            j++;
+        }
+        if (j > i) {
+            out = putControl(out, CAPTURE_SKIP, j - i);
+            i = j;
+            continue;
+        }
+        // 같은 값이 반복되는 구간
+        while (j < count && j - i < CAPTURE_MAX_COUNT && cur[j] == cur[i]) {
+            j++;
+        }
+        if (j - i >= CAPTURE_MIN_RUN) {
+            out = putControl(out, CAPTURE_RUN, j - i);
+            memcpy(out, &cur[i], sizeof(FIXEL_FORMAT));
+            out += sizeof(FIXEL_FORMAT);
+            i = j;
+            continue;
+        }
+        // 그대로 적을 구간: 바뀌지 않은 픽셀이나 반복이 시작되기 전까지
+        j = i + 1;
+        while (j < count && j - i < CAPTURE_MAX_COUNT && cur[j] != prev[j] &&
+               !(j + CAPTURE_MIN_RUN <= count && cur[j] == cur[j + 1] && cur[j] == cur[j + 2])) {
+            j++;
+        }
+        out = putControl(out, CAPTURE_LITERAL, j - i);
+        memcpy(out, &cur[i], (j - i) * sizeof(FIXEL_FORMAT));
+        out += (j - i) * sizeof(FIXEL_FORMAT);
+        i = j;
+    }
+    return out - start;
+}
+
+// 앞 프레임이 들어 있는 frame 위에 차이를 적용합니다. 데이터가 잘못되었으면 false
+bool decodeDelta(const uint8_t* in, size_t size, FIXEL_FORMAT* frame, int count) {
+    const uint8_t* end = in + size;
+    int i = 0;
+    while (in + sizeof(uint16_t) <= end) {
+        uint16_t control;
+        memcpy(&control, in, sizeof(control));
+        in += sizeof(control);
+        int type = control >> 14, n = control & CAPTURE_MAX_COUNT;
+        if (i + n > count) {
+            return false;
+        }
+        if (type == CAPTURE_SKIP) {
+            // 앞 프레임 값을 그대로 둡니다.
+        } else if (type == CAPTURE_RUN) {
+            if (in + sizeof(FIXEL_FORMAT) > end) {
+                return false;
+            }
+            FIXEL_FORMAT value;
+            memcpy(&value, in, sizeof(value));
+            in += sizeof(value);
+            std::fill(frame + i, frame + i + n, value);
+        } else if (type == CAPTURE_LITERAL) {
+            if (in + n * sizeof(FIXEL_FORMAT) > end) {
+                return false;
+            }
+            memcpy(frame + i, in, n * sizeof(FIXEL_FORMAT));
+            in += n * sizeof(FIXEL_FORMAT);
+        } else {
+            return false;
+        }
+        i += n;
+    }
+    return i == count;
+}
+
+class FrameCapture {
+private:
+    FILE * file = nullptr;
+    int width = 0, height = 0;
+    FIXEL_FORMAT* slots[CAPTURE_QUEUE_SLOTS] = {};
+    uint32_t slotFrames[CAPTURE_QUEUE_SLOTS];
+    std::atomic<uint32_t> head{0};      // 게임 루프만 씀
+    std::atomic<uint32_t> tail{0};      // 녹화 스레드만 씀
+    std::atomic<bool> stopping{false};
+    std::thread writer;
+    FIXEL_FORMAT* previous = nullptr;   // 마지막으로 기록한 프레임 (녹화 스레드 전용)
+    uint8_t* encoded = nullptr;
+
+    void writeFrame(const FIXEL_FORMAT* pixels, uint32_t frame) {
+        double start = nowSeconds();
+        int count = width * height;
+        RenderTarget target;
+        target.base = (uint8_t*)pixels;
+        target.stride = width * sizeof(FIXEL_FORMAT);
+        target.width = width;
+        target.height = height;
+        target.bitsPerPixel = sizeof(FIXEL_FORMAT) * 8;
+        CaptureFrameHeader record;
+        record.frame = frame;
+        record.checksum = frameChecksum(target);
+        record.bytes = (uint32_t)encodeDelta(pixels, previous, count, encoded);
+        memcpy(previous, pixels, count * sizeof(FIXEL_FORMAT));
+        fwrite(&record, sizeof(record), 1, file);
+        fwrite(encoded, 1, record.bytes, file);
+        bytes += sizeof(record) + record.bytes;
+        written++;
+        maxEncodeSeconds = std::max(maxEncodeSeconds, nowSeconds() - start);
+    }
+
+    void run() {
+        while (true) {
+            uint32_t t = tail.load(std::memory_order_relaxed);
+            if (t == head.load(std::memory_order_acquire)) {
+                if (stopping.load(std::memory_order_acquire)) {
+                    break;
+                }
+                usleep(1000);
+                continue;
+            }
+            int index = t % CAPTURE_QUEUE_SLOTS;
+            writeFrame(slots[index], slotFrames[index]);
+            tail.store(t + 1, std::memory_order_release);
+        }
+        fflush(file);
+    }
+
+public:
+    // 게임 루프 쪽 통계
+    long pushed = 0;
+    long dropped = 0;
+    // 녹화 스레드 쪽 통계 (close 뒤에 읽습니다)
+    long written = 0;
+    long bytes = 0;
+    double maxEncodeSeconds = 0.0;
+
+    ~FrameCapture() {
+        close();
+        for (FIXEL_FORMAT* slot : slots) {
+            countedFree(slot);
+        }
+        countedFree(previous);
+        countedFree(encoded);
+    }
+
+    bool open(const char * path, int w, int h) {
+        file = fopen(path, "wb");
+        if (file == nullptr) {
+            std::cerr << "Error: cannot open capture file " << path << "." << std::endl;
+            return false;
+        }
+        width = w;
+        height = h;
+        CaptureHeader header;
+        memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+        header.version = CAPTURE_VERSION;
+        header.pixelBits = sizeof(FIXEL_FORMAT) * 8;
+        header.width = w;
+        header.height = h;
+        fwrite(&header, sizeof(header), 1, file);
+
+        // 녹화 중에는 힙 할당이 없도록 칸과 작업 버퍼를 모두 미리 잡아 둡니다.
+        size_t frameBytes = (size_t)w * h * sizeof(FIXEL_FORMAT);
+        for (FIXEL_FORMAT* &slot : slots) {
+            slot = (FIXEL_FORMAT*)countedAlloc((frameBytes + SURFACE_ALIGN - 1) & ~(SURFACE_ALIGN - 1), SURFACE_ALIGN);
+            // 첫 push에서 페이지 폴트가 나지 않도록 미리 만져 둡니다.
+            memset(slot, 0, frameBytes);
+        }
+        previous = (FIXEL_FORMAT*)countedAlloc(frameBytes, SURFACE_ALIGN);
+        memset(previous, 0, frameBytes);
+        encoded = (uint8_t*)countedAlloc(deltaBound(w * h), 0);
+        writer = std::thread([this]() { run(); });
+        return true;
+    }
+
+    // 백버퍼를 빈 칸에 복사해 큐에 넣습니다. 빈 칸이 없으면 버리고 false
+    bool push(const RenderTarget &buffer, uint32_t frame) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= (uint32_t)CAPTURE_QUEUE_SLOTS) {
+            dropped++;
+            return false;
+        }
+        int index = h % CAPTURE_QUEUE_SLOTS;
+        int w = std::min(width, buffer.width);
+        for (int y = 0; y < std::min(height, buffer.height); ++y) {
+            memcpy(slots[index] + (size_t)y * width, buffer.row(y), w * sizeof(FIXEL_FORMAT));
+        }
+        slotFrames[index] = frame;
+        head.store(h + 1, std::memory_order_release);
+        pushed++;
+        return true;
+    }
+
+    // 큐에 남은 프레임을 모두 쓰고 닫습니다.
+    void close() {
+        if (writer.joinable()) {
+            stopping.store(true, std::memory_order_release);
+            writer.join();
+        }
+        if (file != nullptr) {
+            fclose(file);
+            file = nullptr;
+        }
+    }
+};
+
+// 24비트 BMP로 저장 (아래 행부터)
+bool writeBmp(const char * path, const FIXEL_FORMAT* pixels, int width, int height) {
+    FILE * bmp = fopen(path, "wb");
+    if (bmp == nullptr) {
+        std::cerr << "Error: cannot create " << path << "." << std::endl;
+        return false;
+    }
+    int rowBytes = (width * 3 + 3) & ~3;
+    uint8_t header[54];
+    memset(header, 0, sizeof(header));
+    header[0] = 'B';
+    header[1] = 'M';
+    *(uint32_t*)&header[2] = sizeof(header) + rowBytes * height;
+    *(uint32_t*)&header[10] = sizeof(header);
+    *(uint32_t*)&header[14] = 40;
+    *(int32_t*)&header[18] = width;
+    *(int32_t*)&header[22] = height;
+    *(uint16_t*)&header[26] = 1;
+    *(uint16_t*)&header[28] = 24;
+    *(uint32_t*)&header[34] = rowBytes * height;
+    fwrite(header, 1, sizeof(header), bmp);
+    std::vector<uint8_t> row(rowBytes, 0);
+    for (int y = height - 1; y >= 0; --y) {
+        for (int x = 0; x < width; ++x) {
+            Color color = convertFrom(pixels[(size_t)y * width + x]);
+            row[x * 3] = color.b;
+            row[x * 3 + 1] = color.g;
+            row[x * 3 + 2] = color.r;
+        }
+        fwrite(row.data(), 1, rowBytes, bmp);
+    }
+    fclose(bmp);
+    return true;
+}
@@ -0,0 +1,223 @@
+// 공유 메모리 프레임 내보내기 (--shm): seqlock 링의 쓰는 쪽(FrameRingWriter)과 읽는 쪽(FrameRingReader)
+// 6_engine.cpp에서 RenderTarget 등이 정의된 뒤에 include됩니다.
+#pragma once
+
+// 공유 메모리 프레임 링 (--shm name)
+// 게임은 매 프레임 백버퍼를 N칸짜리 링의 다음 칸에 복사하고, 다른 프로세스는 같은 이름으로
+// shm_open 해서 복사 없이 제자리에서 읽습니다. 칸마다 seqlock 번호를 두어 락 없이 동기화합니다.
+//   쓰기: 번호를 홀수로 -> 픽셀 쓰기 -> 번호를 짝수로 -> latest 갱신
+//   읽기: 번호가 짝수인지 확인 -> 픽셀 읽기 -> 번호가 그대로인지 확인 (달라졌으면 찢어진 프레임이므로 다시)
+// 게임은 읽는 쪽을 기다리지 않습니다. 읽는 쪽이 느리면 중간 프레임을 건너뜁니다.
+// [FrameRingHeader][FrameSlotHeader][픽셀] x slots
+const char FRAME_RING_MAGIC[4] = {'F', 'B', 'S', 'M'};
+const uint32_t FRAME_RING_VERSION = 1;
+const int FRAME_RING_SLOTS = 3;
+
+struct alignas(64) FrameRingHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t width, height;
+    int32_t stride;         // 한 행의 바이트 수
+    int32_t bitsPerPixel;
+    int32_t slots;
+    uint32_t slotBytes;     // 칸 하나의 크기 (FrameSlotHeader 포함)
+    std::atomic<uint64_t> latest;   // 마지막으로 다 쓴 프레임 번호 + 1 (0이면 아직 없음)
+};
+
+struct alignas(64) FrameSlotHeader {
+    std::atomic<uint64_t> sequence; // 홀수면 쓰는 중
+    uint64_t frame;
+    uint32_t checksum;      // frameChecksum 값 (계산하지 않은 프레임은 0)
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "frame ring needs lock-free 64-bit atomics");
+
+class FrameRingWriter {
+private:
+    int fd = -1;
+    uint8_t* memory = nullptr;
+    size_t size = 0;
+    char name[64];
+    FrameRingHeader* header = nullptr;
+
+    FrameSlotHeader* slot(int index) const {
+        return (FrameSlotHeader*)(memory + sizeof(FrameRingHeader) + (size_t)index * header->slotBytes);
+    }
+
+public:
+    long published = 0;
+
+    ~FrameRingWriter() {
+        if (memory != nullptr) {
+            munmap(memory, size);
+        }
+        if (fd != -1) {
+            close(fd);
+            shm_unlink(name);
+        }
+    }
+
+    bool open(const char * shmName, int width, int height) {
+        snprintf(name, sizeof(name), "%s", shmName);
+        fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd == -1) {
+            std::cerr << "Error: cannot create shared memory " << name << "." << std::endl;
+            return false;
+        }
+        int stride = (int)((width * sizeof(FIXEL_FORMAT) + SURFACE_ALIGN - 1) & ~(SURFACE_ALIGN - 1));
+        uint32_t slotBytes = (uint32_t)(sizeof(FrameSlotHeader) + (size_t)stride * height);
+        size = sizeof(FrameRingHeader) + (size_t)slotBytes * FRAME_RING_SLOTS;
+        if (ftruncate(fd, size) == -1) {
+            std::cerr << "Error: cannot resize shared memory " << name << "." << std::endl;
+            return false;
+        }
+        void* ptr = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ptr == MAP_FAILED) {
+            std::cerr << "Error: cannot map shared memory " << name << "." << std::endl;
+            return false;
+        }
+        memory = (uint8_t*)ptr;
+        header = new (memory) FrameRingHeader();
+        header->version = FRAME_RING_VERSION;
+        header->width = width;
+        header->height = height;
+        header->stride = stride;
+        header->bitsPerPixel = sizeof(FIXEL_FORMAT) * 8;
+        header->slots = FRAME_RING_SLOTS;
+        header->slotBytes = slotBytes;
+        header->latest.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < FRAME_RING_SLOTS; ++i) {
+            new (slot(i)) FrameSlotHeader();
+            slot(i)->sequence.store(0, std::memory_order_relaxed);
+        }
+        // 머리를 다 채운 뒤에 매직을 써서 읽는 쪽이 반쯤 만든 링을 보지 않게 합니다.
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(header->magic, FRAME_RING_MAGIC, sizeof(header->magic));
+        return true;
+    }
+
+    // 백버퍼를 다음 칸에 복사하고 공개합니다. 기다리는 일은 없습니다.
+    void publish(const RenderTarget &buffer, uint64_t frame, uint32_t checksum) {
+        FrameSlotHeader* s = slot((int)(frame % FRAME_RING_SLOTS));
+        uint64_t sequence = s->sequence.load(std::memory_order_relaxed);
+        s->sequence.store(sequence + 1, std::memory_order_relaxed);
+        // 아래 streamRow의 non-temporal 저장은 release 펜스로도 앞의 저장 뒤로 순서가 보장되지 않으므로
+        // sfence로 홀수 sequence가 먼저 보이게 합니다.
+        std::atomic_thread_fence(std::memory_order_release);
+        #if defined(__SSE2__)
+        _mm_sfence();
+        #endif
+        s->frame = frame;
+        s->checksum = checksum;
+        uint8_t* pixels = (uint8_t*)(s + 1);
+        int width = std::min(buffer.width, header->width);
+        int height = std::min(buffer.height, header->height);
+        for (int y = 0; y < height; ++y) {
+            streamRow((FIXEL_FORMAT*)(pixels + (size_t)y * header->stride), buffer.row(y), width);
+        }
+        #if defined(__SSE2__)
+        _mm_sfence();
+        #endif
+        s->sequence.store(sequence + 2, std::memory_order_release);
+        header->latest.store(frame + 1, std::memory_order_release);
+        published++;
+    }
+};
+
+// 프레임 링을 읽는 쪽 (--shm-read, 다른 프로세스)
+class FrameRingReader {
+private:
+    int fd = -1;
+    uint8_t* memory = nullptr;
+    size_t size = 0;
+    const FrameRingHeader* header = nullptr;
+
+    const FrameSlotHeader* slot(int index) const {
+        return (const FrameSlotHeader*)(memory + sizeof(FrameRingHeader) + (size_t)index * header->slotBytes);
+    }
+
+public:
+    long retries = 0;   // 쓰는 중이거나 읽는 도중 덮어써져서 다시 읽은 횟수
+
+    ~FrameRingReader() {
+        if (memory != nullptr) {
+            munmap(memory, size);
+        }
+        if (fd != -1) {
+            close(fd);
+        }
+    }
+
+    bool open(const char * shmName) {
+        fd = shm_open(shmName, O_RDONLY, 0);
+        if (fd == -1) {
+            std::cerr << "Error: cannot open shared memory " << shmName << "." << std::endl;
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) == -1 || (size_t)info.st_size < sizeof(FrameRingHeader)) {
+            std::cerr << "Error: shared memory " << shmName << " is too small." << std::endl;
+            return false;
+        }
+        size = info.st_size;
+        void* ptr = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (ptr == MAP_FAILED) {
+            std::cerr << "Error: cannot map shared memory " << shmName << "." << std::endl;
+            return false;
+        }
+        memory = (uint8_t*)ptr;
+        header = (const FrameRingHeader*)memory;
+        if (memcmp(header->magic, FRAME_RING_MAGIC, sizeof(header->magic)) != 0 ||
+            header->version != FRAME_RING_VERSION || header->bitsPerPixel != (int)sizeof(FIXEL_FORMAT) * 8 ||
+            sizeof(FrameRingHeader) + (size_t)header->slotBytes * header->slots > size) {
+            std::cerr << "Error: " << shmName << " is not a compatible frame ring." << std::endl;
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return true;
+    }
+
+    int width() const { return header->width; }
+    int height() const { return header->height; }
+
+    // 마지막으로 공개된 프레임 번호 + 1 (0이면 아직 없음)
+    uint64_t latest() const {
+        return header->latest.load(std::memory_order_acquire);
+    }
+
+    // 가장 최근 프레임을 제자리에서 visit(target, frame, checksum)로 읽습니다.
+    // visit이 끝난 뒤 번호가 바뀌었으면 찢어진 읽기이므로 버리고 다시 읽습니다.
+    // visit은 찢어진 데이터를 볼 수도 있으므로 결과는 이 함수가 true를 돌려준 뒤에만 씁니다.
+    template <typename F>
+    bool readLatest(F &visit, uint64_t &frame) {
+        while (true) {
+            uint64_t latestFrame = latest();
+            if (latestFrame == 0) {
+                return false;
+            }
+            const FrameSlotHeader* s = slot((int)((latestFrame - 1) % header->slots));
+            uint64_t before = s->sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                retries++;
+                continue;
+            }
+            uint64_t slotFrame = s->frame;
+            uint32_t checksum = s->checksum;
+            RenderTarget target;
+            target.base = (uint8_t*)(s + 1);
+            target.stride = header->stride;
+            target.width = header->width;
+            target.height = header->height;
+            target.bitsPerPixel = header->bitsPerPixel;
+            target.clip = ClipStack(target.width, target.height);
+            visit(target, slotFrame, checksum);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s->sequence.load(std::memory_order_relaxed) != before) {
+                retries++;
+                continue;
+            }
+            frame = slotFrame;
+            return true;
+        }
+    }
+};
@@ -0,0 +1,440 @@
+// 고정소수점 물리: 스윕 충돌(sweepBox/stepBody), X축 브로드 페이즈, 범위별 병렬 PhysicsWorld
+// 6_engine.cpp에서 Fixed, WorkerPool 등이 정의된 뒤, 유닛 클래스 앞에 include됩니다.
+#pragma once
+
+// 고정소수점 (16.16) 물리
+// 위치와 속도를 1/65536 픽셀 단위로 다루므로 스텝 크기와 관계없이 결과가 결정적입니다.
+
+enum CrashCode {
+    NONE = 0,
+    TOP = 1,
+    BOTTOM = 2,
+    LEFT = 3,
+    RIGHT = 4,
+};
+
+// 움직이지 않는 충돌 상자
+struct Box {
+    Fixed x, y, w, h;
+};
+
+// 움직이는 물체
+struct Body {
+    Fixed x, y, w, h;
+    Fixed vx, vy;   // 틱당 이동 거리
+};
+
+struct SweepHit {
+    Fixed time;     // 스텝 안에서 처음 닿는 시각 (0 ~ FIXED_ONE)
+    CrashCode code; // 물체가 닿은 상자의 면 (TOP이면 상자 위에 떨어짐)
+    int index;
+};
+
+// 물체가 (dx, dy)만큼 움직이는 동안 상자와 처음 닿는 시각을 구합니다 (swept AABB).
+// 끝 위치만 검사하지 않으므로 한 스텝에 상자 두께보다 많이 움직여도 뚫고 지나가지 않습니다.
+// 시작할 때 이미 겹쳐 있는 상자는 무시합니다.
+bool sweepBox(const Body &body, Fixed dx, Fixed dy, const Box &box, SweepHit &hit) {
+    // 가장자리 좌표는 넘치지 않도록 64비트로 계산합니다.
+    const long long NEVER = (long long)1 << 40;
+    const long long bodyRight = (long long)body.x + body.w, bodyBottom = (long long)body.y + body.h;
+    const long long boxRight = (long long)box.x + box.w, boxBottom = (long long)box.y + box.h;
+    long long entryX, exitX, entryY, exitY;
+    if (dx > 0) {
+        entryX = (box.x - bodyRight) * FIXED_ONE / dx;
+        exitX = (boxRight - body.x) * FIXED_ONE / dx;
+    } else if (dx < 0) {
+        entryX = (boxRight - body.x) * FIXED_ONE / dx;
+        exitX = (box.x - bodyRight) * FIXED_ONE / dx;
+    } else {
+        if (bodyRight <= box.x || body.x >= boxRight) {
+            return false;
+        }
+        entryX = -NEVER;
+        exitX = NEVER;
+    }
+    if (dy > 0) {
+        entryY = (box.y - bodyBottom) * FIXED_ONE / dy;
+        exitY = (boxBottom - body.y) * FIXED_ONE / dy;
+    } else if (dy < 0) {
+        entryY = (boxBottom - body.y) * FIXED_ONE / dy;
+        exitY = (box.y - bodyBottom) * FIXED_ONE / dy;
+    } else {
+        if (bodyBottom <= box.y || body.y >= boxBottom) {
+            return false;
+        }
+        entryY = -NEVER;
+        exitY = NEVER;
+    }
+
+    long long enter = std::max(entryX, entryY);
+    long long exit = std::min(exitX, exitY);
+    if (enter > exit || enter < 0 || enter >= FIXED_ONE || exit <= 0) {
+        return false;
+    }
+    hit.time = (Fixed)enter;
+    if (entryX > entryY) {
+        hit.code = dx > 0 ? LEFT : RIGHT;
+    } else {
+        hit.code = dy > 0 ? TOP : BOTTOM;
+    }
+    return true;
+}
+
+// 한 스텝(dt 틱) 동안 중력을 받으며 움직입니다.
+// 가장 먼저 닿는 상자까지만 이동한 뒤 면에 맞춰 반응하고, 남은 시간만큼 다시 이동합니다.
+// 위에 떨어지면 bounce 속도로 튀어 오르고, 아래나 옆에 부딪히면 그 방향 속도를 잃습니다.
+// 반환값은 이번 스텝에 닿은 면의 비트 집합 (1 << CrashCode) 입니다.
+unsigned stepBody(Body &body, const Box * boxes, int count, Fixed dt, Fixed gravity, Fixed bounce) {
+    body.vy += fixedMul(gravity, dt);
+    unsigned contacts = 0;
+    Fixed remaining = FIXED_ONE;
+    for (int iteration = 0; iteration < MAX_SWEEP_ITERATIONS && remaining > 0; ++iteration) {
+        Fixed dx = fixedMul(fixedMul(body.vx, dt), remaining);
+        Fixed dy = fixedMul(fixedMul(body.vy, dt), remaining);
+        if (dx == 0 && dy == 0) {
+            break;
+        }
+        SweepHit first = {FIXED_ONE, NONE, -1};
+        for (int i = 0; i < count; ++i) {
+            SweepHit hit;
+            if (sweepBox(body, dx, dy, boxes[i], hit) && hit.time < first.time) {
+                first = hit;
+                first.index = i;
+            }
+        }
+        body.x += fixedMul(dx, first.time);
+        body.y += fixedMul(dy, first.time);
+        if (first.code == NONE) {
+            break;
+        }
+
+        // 반올림 때문에 파고들지 않도록 닿은 면에 정확히 맞춥니다.
+        const Box &box = boxes[first.index];
+        switch (first.code) {
+            case TOP:
+                body.y = box.y - body.h;
+                body.vy = bounce;
+                break;
+            case BOTTOM:
+                body.y = box.y + box.h;
+                body.vy = 0;
+                break;
+            case LEFT:
+                body.x = box.x - body.w;
+                body.vx = 0;
+                break;
+            case RIGHT:
+                body.x = box.x + box.w;
+                body.vx = 0;
+                break;
+            default:
+                break;
+        }
+        contacts |= 1u << first.code;
+        remaining -= fixedMul(remaining, first.time);
+    }
+    return contacts;
+}
+
+// 한 스텝 동안 물체가 닿을 수 있는 범위
+// 가로 속도는 충돌해도 0이 될 뿐이고, 세로 속도는 중력을 받은 뒤의 값이나 튀어 오르는 값을 넘지 않습니다.
+Box sweptBounds(const Body &body, Fixed dt, Fixed gravity, Fixed bounce) {
+    Fixed dx = std::abs(fixedMul(body.vx, dt));
+    Fixed vy = std::max(std::abs(body.vy + fixedMul(gravity, dt)), std::abs(bounce));
+    Fixed dy = fixedMul(vy, dt);
+    return {body.x - dx, body.y - dy, body.w + dx * 2, body.h + dy * 2};
+}
+
+// 훑을 때 원래 배열을 다시 찾아가지 않도록 Y 범위도 함께 둡니다.
+struct BroadPhaseEntry {
+    Fixed minX, maxX;
+    Fixed minY, maxY;
+    int index;
+};
+
+struct CollisionPair {
+    int a, b;   // a < b 가 항상 성립하지는 않습니다 (X축 정렬 순서)
+};
+
+// X축 sort-and-sweep 브로드 페이즈
+// 상자들을 왼쪽 끝(minX) 순서로 정렬해 두고, 오른쪽으로 훑으면서 X 구간이 겹치는 것만 Y를 검사합니다.
+// 물체는 프레임마다 조금씩만 움직이므로 지난 순서에서 삽입 정렬을 하면 거의 O(n)입니다.
+class BroadPhase {
+private:
+    BroadPhaseEntry* entries = nullptr;
+    int capacity = 0;
+    int count = 0;
+
+public:
+    long swaps = 0;     // 마지막 update에서 자리를 바꾼 횟수
+
+    BroadPhase(int maxEntries) : capacity(maxEntries) {
+        entries = new BroadPhaseEntry[maxEntries];
+    }
+    ~BroadPhase() {
+        delete[] entries;
+    }
+    BroadPhase(const BroadPhase &) = delete;
+    BroadPhase &operator=(const BroadPhase &) = delete;
+
+    int size() const {
+        return count;
+    }
+
+    // 상자 범위를 새로 읽어 정렬합니다. 개수가 바뀌면 순서를 처음부터 다시 만듭니다.
+    void update(const Box * bounds, int boundsCount) {
+        boundsCount = std::min(boundsCount, capacity);
+        bool rebuild = boundsCount != count;
+        if (rebuild) {
+            count = boundsCount;
+            for (int i = 0; i < count; ++i) {
+                entries[i].index = i;
+            }
+        }
+        for (int i = 0; i < count; ++i) {
+            const Box &box = bounds[entries[i].index];
+            entries[i].minX = box.x;
+            entries[i].maxX = box.x + box.w;
+            entries[i].minY = box.y;
+            entries[i].maxY = box.y + box.h;
+        }
+
+        swaps = 0;
+        if (rebuild) {
+            // 지난 순서가 없으면 삽입 정렬은 O(n^2)이므로 한 번 전체 정렬합니다.
+            std::sort(entries, entries + count, [](const BroadPhaseEntry &a, const BroadPhaseEntry &b) {
+                return a.minX != b.minX ? a.minX < b.minX : a.index < b.index;
+            });
+            return;
+        }
+        for (int i = 1; i < count; ++i) {
+            BroadPhaseEntry entry = entries[i];
+            int j = i - 1;
+            while (j >= 0 && entries[j].minX > entry.minX) {
+                entries[j + 1] = entries[j];
+                j--;
+                swaps++;
+            }
+            entries[j + 1] = entry;
+        }
+    }
+
+    // 범위가 겹치는 쌍을 찾습니다. 쌍이 maxPairs보다 많으면 나머지는 버립니다.
+    int findPairs(CollisionPair * pairs, int maxPairs) const {
+        return findPairsInRange(0, count, pairs, maxPairs);
+    }
+
+    // 정렬 순서로 [begin, end) 구간에서 시작하는 쌍만 찾습니다. 구간마다 따로 돌릴 수 있습니다.
+    int findPairsInRange(int begin, int end, CollisionPair * pairs, int maxPairs) const {
+        int pairCount = 0;
+        end = std::min(end, count);
+        for (int i = begin; i < end; ++i) {
+            const BroadPhaseEntry &a = entries[i];
+            for (int j = i + 1; j < count && entries[j].minX < a.maxX; ++j) {
+                const BroadPhaseEntry &b = entries[j];
+                if (a.minY < b.maxY && b.minY < a.maxY) {
+                    if (pairCount == maxPairs) {
+                        return pairCount;
+                    }
+                    pairs[pairCount++] = {a.index, b.index};
+                }
+            }
+        }
+        return pairCount;
+    }
+};
+
+// 두 물체가 겹쳤을 때의 반응
+// a와 b에 더할 위치 보정, a에 더하고 b에서 뺄 속도 변화입니다.
+struct Contact {
+    int a, b;
+    Fixed ax, ay, bx, by;
+    Fixed dvx, dvy;
+};
+
+// 겹친 두 물체를 덜 겹친 축으로 반씩 밀어내고 그 축의 속도를 맞바꾸는 반응을 구합니다.
+// 반환값은 a가 b의 어느 면에 닿았는지입니다 (TOP이면 a가 b 위에 있음).
+CrashCode makeContact(const Body &a, const Body &b, Contact &contact) {
+    Fixed overlapX = std::min(a.x + a.w, b.x + b.w) - std::max(a.x, b.x);
+    Fixed overlapY = std::min(a.y + a.h, b.y + b.h) - std::max(a.y, b.y);
+    if (overlapX <= 0 || overlapY <= 0) {
+        return NONE;
+    }
+    contact.ax = contact.ay = contact.bx = contact.by = 0;
+    contact.dvx = contact.dvy = 0;
+    CrashCode code;
+    if (overlapX < overlapY) {
+        Fixed half = overlapX / 2;
+        code = a.x < b.x ? LEFT : RIGHT;
+        contact.ax = code == LEFT ? -half : half;
+        contact.bx = code == LEFT ? overlapX - half : half - overlapX;
+        contact.dvx = b.vx - a.vx;
+    } else {
+        Fixed half = overlapY / 2;
+        code = a.y < b.y ? TOP : BOTTOM;
+        contact.ay = code == TOP ? -half : half;
+        contact.by = code == TOP ? overlapY - half : half - overlapY;
+        contact.dvy = b.vy - a.vy;
+    }
+    return code;
+}
+
+inline void applyContact(Body &a, Body &b, const Contact &contact) {
+    a.x += contact.ax;
+    a.y += contact.ay;
+    b.x += contact.bx;
+    b.y += contact.by;
+    a.vx += contact.dvx;
+    a.vy += contact.dvy;
+    b.vx -= contact.dvx;
+    b.vy -= contact.dvy;
+}
+
+// 여러 접촉의 반응을 한꺼번에 더할 때 쓰는 버전
+// 물체마다 닿은 수로 나눠서 더하므로 접촉이 많아도 속도가 불어나지 않습니다.
+inline void applyContactShared(Body &a, Body &b, const Contact &contact, int touchesA, int touchesB) {
+    a.x += contact.ax / touchesA;
+    a.y += contact.ay / touchesA;
+    a.vx += contact.dvx / touchesA;
+    a.vy += contact.dvy / touchesA;
+    b.x += contact.bx / touchesB;
+    b.y += contact.by / touchesB;
+    b.vx -= contact.dvx / touchesB;
+    b.vy -= contact.dvy / touchesB;
+}
+
+// 겹친 두 물체를 바로 떼어 놓습니다.
+CrashCode resolveOverlap(Body &a, Body &b) {
+    Contact contact;
+    CrashCode code = makeContact(a, b, contact);
+    if (code != NONE) {
+        applyContact(a, b, contact);
+    }
+    return code;
+}
+
+// 많은 물체를 한꺼번에 움직이는 물리 월드
+// 물체를 PHYSICS_CHUNK 개씩 나눠 작업 스레드에 맡깁니다. 나누는 방식이 스레드 수와 관계없고
+// 각 구간은 자기 출력만 쓰므로 결과는 스레드 수와 관계없이 같습니다.
+//   1. 적분: 물체마다 정적 상자에 대해 stepBody (물체끼리 주고받는 값이 없음)
+//   2. 브로드 페이즈 정렬 (한 스레드)
+//   3. 정렬 순서의 구간별로 겹치는 쌍을 찾고 반응을 계산 (적분이 끝난 상태만 읽음)
+//   4. 반응을 물체마다 닿은 수로 나눠 적용 (정수 덧셈이므로 순서와 관계없이 같은 값)
+class PhysicsWorld {
+private:
+    Body* bodies = nullptr;
+    Box* bounds = nullptr;
+    CollisionPair* pairs = nullptr;     // 구간마다 PHYSICS_CHUNK * MAX_CONTACTS_PER_BODY 칸
+    Contact* contacts = nullptr;
+    int* contactCounts = nullptr;
+    int* touches = nullptr;             // 물체마다 이번 스텝에 닿은 수
+    int capacity;
+    int count = 0;
+    const Box * statics = nullptr;
+    int staticCount = 0;
+    BroadPhase broadPhase;
+    Fixed stepDt = FIXED_ONE;
+
+    int chunkCount() const {
+        return (count + PHYSICS_CHUNK - 1) / PHYSICS_CHUNK;
+    }
+
+    static void integrateChunk(void* context, int chunk) {
+        PhysicsWorld &world = *(PhysicsWorld*)context;
+        int end = std::min(world.count, (chunk + 1) * PHYSICS_CHUNK);
+        for (int i = chunk * PHYSICS_CHUNK; i < end; ++i) {
+            Body &body = world.bodies[i];
+            stepBody(body, world.statics, world.staticCount, world.stepDt, world.gravity, world.bounce);
+            world.bounds[i] = {body.x, body.y, body.w, body.h};
+        }
+    }
+
+    static void collideChunk(void* context, int chunk) {
+        PhysicsWorld &world = *(PhysicsWorld*)context;
+        const int slots = PHYSICS_CHUNK * MAX_CONTACTS_PER_BODY;
+        CollisionPair* pairs = world.pairs + (long)chunk * slots;
+        Contact* contacts = world.contacts + (long)chunk * slots;
+        int pairCount = world.broadPhase.findPairsInRange(chunk * PHYSICS_CHUNK, (chunk + 1) * PHYSICS_CHUNK, pairs, slots);
+        int contactCount = 0;
+        for (int i = 0; i < pairCount; ++i) {
+            Contact &contact = contacts[contactCount];
+            if (makeContact(world.bodies[pairs[i].a], world.bodies[pairs[i].b], contact) != NONE) {
+                contact.a = pairs[i].a;
+                contact.b = pairs[i].b;
+                contactCount++;
+            }
+        }
+        world.contactCounts[chunk] = contactCount;
+    }
+
+public:
+    Fixed gravity = toFixed(GRAVITY);
+    Fixed bounce = toFixed(BOUND_GRAVITY);
+    long contactsLastStep = 0;
+
+    PhysicsWorld(int maxBodies) : capacity(maxBodies), broadPhase(maxBodies) {
+        int chunks = (maxBodies + PHYSICS_CHUNK - 1) / PHYSICS_CHUNK;
+        long slots = (long)chunks * PHYSICS_CHUNK * MAX_CONTACTS_PER_BODY;
+        bodies = new Body[maxBodies];
+        bounds = new Box[maxBodies];
+        pairs = new CollisionPair[slots];
+        contacts = new Contact[slots];
+        contactCounts = new int[chunks];
+        touches = new int[maxBodies];
+    }
+    ~PhysicsWorld() {
+        delete[] bodies;
+        delete[] bounds;
+        delete[] pairs;
+        delete[] contacts;
+        delete[] contactCounts;
+        delete[] touches;
+    }
+    PhysicsWorld(const PhysicsWorld &) = delete;
+    PhysicsWorld &operator=(const PhysicsWorld &) = delete;
+
+    // 가득 차면 -1을 반환합니다.
+    int add(const Body &body) {
+        if (count == capacity) {
+            return -1;
+        }
+        bodies[count] = body;
+        return count++;
+    }
+
+    int size() const { return count; }
+    Body &body(int index) { return bodies[index]; }
+    const Body &body(int index) const { return bodies[index]; }
+
+    // 정적 상자는 월드가 소유하지 않습니다.
+    void setStatics(const Box * boxes, int boxCount) {
+        statics = boxes;
+        staticCount = boxCount;
+    }
+
+    void step(Fixed dt, WorkerPool &workers) {
+        stepDt = dt;
+        int chunks = chunkCount();
+        workers.run(chunks, integrateChunk, this);
+        broadPhase.update(bounds, count);
+        workers.run(chunks, collideChunk, this);
+
+        contactsLastStep = 0;
+        memset(touches, 0, count * sizeof(int));
+        for (int chunk = 0; chunk < chunks; ++chunk) {
+            const Contact* chunkContacts = contacts + (long)chunk * PHYSICS_CHUNK * MAX_CONTACTS_PER_BODY;
+            for (int i = 0; i < contactCounts[chunk]; ++i) {
+                touches[chunkContacts[i].a]++;
+                touches[chunkContacts[i].b]++;
+            }
+            contactsLastStep += contactCounts[chunk];
+        }
+        for (int chunk = 0; chunk < chunks; ++chunk) {
+            const Contact* chunkContacts = contacts + (long)chunk * PHYSICS_CHUNK * MAX_CONTACTS_PER_BODY;
+            for (int i = 0; i < contactCounts[chunk]; ++i) {
+                const Contact &contact = chunkContacts[i];
+                applyContactShared(bodies[contact.a], bodies[contact.b], contact, touches[contact.a], touches[contact.b]);
+            }
+        }
+    }
+};
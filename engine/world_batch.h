@@ -0,0 +1,213 @@
+// 렌더링 없는 월드 여러 개를 SoA + SSE2로 한꺼번에 진행하는 WorldBatch (--worlds)
+// 6_engine.cpp에서 물리(engine/physics.h)와 WorkerPool이 정의된 뒤에 include됩니다.
+#pragma once
+
+// 렌더링 없이 독립된 월드 여러 개를 한꺼번에 진행합니다 (봇 테스트, 값 조정용).
+// 월드마다 공 하나가 같은 레벨 위에서 각자의 입력(틱당 가로 이동 픽셀)으로 움직입니다.
+// 상태는 SoA 배열로 두고 네 월드씩 SSE2로 처리합니다.
+//   1. 스윕 범위를 구해 상자마다 네 월드를 한 번에 겹침 검사
+//   2. 어느 상자와도 겹치지 않는 월드는 벡터로 적분 (공중에 떠 있는 대부분의 틱)
+//   3. 겹치는 월드만 겹친 상자들로 stepBody
+// 한 스텝은 한 틱이고, 결과는 월드마다 모든 상자로 stepBody를 돌린 것과 같습니다.
+// 월드는 WORLD_CHUNK개씩 작업 스레드에 나누므로 스레드 수와 관계없이 결과가 같습니다.
+class WorldBatch {
+private:
+    Fixed* x = nullptr;
+    Fixed* y = nullptr;
+    Fixed* vx = nullptr;
+    Fixed* vy = nullptr;
+    int* input = nullptr;
+    unsigned* contacts = nullptr;
+    int* bounces = nullptr;
+    int count;
+    int padded;     // 4의 배수로 늘린 개수 (남는 칸도 같이 진행하지만 보이지 않습니다)
+    // 월드마다 닿을 수 있는 상자 집합 (땅 + 블록이라 64비트 하나로는 모자랍니다)
+    typedef std::bitset<MAX_BLOCKS + 1> CandidateMask;
+
+    Box statics[MAX_BLOCKS + 1];
+    Fixed boxX0[MAX_BLOCKS + 1], boxX1[MAX_BLOCKS + 1];
+    Fixed boxY0[MAX_BLOCKS + 1], boxY1[MAX_BLOCKS + 1];
+    int staticCount;
+    Fixed bodyW, bodyH;
+
+    template <typename T>
+    static T* allocArray(int n) {
+        T* array = (T*)countedAlloc(((n * sizeof(T) + SURFACE_ALIGN - 1) & ~(SURFACE_ALIGN - 1)), SURFACE_ALIGN);
+        memset(array, 0, n * sizeof(T));
+        return array;
+    }
+
+    #if defined(__SSE2__)
+    static __m128i abs4(__m128i v) {
+        __m128i sign = _mm_srai_epi32(v, 31);
+        return _mm_sub_epi32(_mm_xor_si128(v, sign), sign);
+    }
+
+    static __m128i max4(__m128i a, __m128i b) {
+        __m128i greater = _mm_cmpgt_epi32(a, b);
+        return _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b));
+    }
+    #endif
+
+    // 월드 하나를 닿을 수 있는 상자들로 진행합니다.
+    void stepWorld(int i, const CandidateMask &candidates) {
+        Box boxes[MAX_BLOCKS + 1];
+        int n = 0;
+        for (int k = 0; k < staticCount; ++k) {
+            if (candidates.test(k)) {
+                boxes[n++] = statics[k];
+            }
+        }
+        Body body = {x[i], y[i], bodyW, bodyH, toFixed(input[i]), vy[i]};
+        unsigned touched = stepBody(body, boxes, n, FIXED_ONE, gravity, bounce);
+        x[i] = body.x;
+        y[i] = body.y;
+        vx[i] = body.vx;
+        vy[i] = body.vy;
+        contacts[i] = touched;
+        bounces[i] += (touched >> TOP) & 1;
+    }
+
+    // 네 월드 [base, base + 4)
+    void stepGroup(int base) {
+        CandidateMask candidates[4];
+        #if defined(__SSE2__)
+        __m128i px = _mm_load_si128((const __m128i*)(x + base));
+        __m128i py = _mm_load_si128((const __m128i*)(y + base));
+        __m128i pvx = _mm_slli_epi32(_mm_load_si128((const __m128i*)(input + base)), FIXED_SHIFT);
+        __m128i pvy = _mm_add_epi32(_mm_load_si128((const __m128i*)(vy + base)), _mm_set1_epi32(gravity));
+
+        // sweptBounds와 같은 범위 (dt = 1틱)
+        __m128i dx = abs4(pvx);
+        __m128i dy = max4(abs4(pvy), _mm_set1_epi32(std::abs(bounce)));
+        __m128i x0 = _mm_sub_epi32(px, dx);
+        __m128i x1 = _mm_add_epi32(_mm_add_epi32(px, _mm_set1_epi32(bodyW)), dx);
+        __m128i y0 = _mm_sub_epi32(py, dy);
+        __m128i y1 = _mm_add_epi32(_mm_add_epi32(py, _mm_set1_epi32(bodyH)), dy);
+        int anyHit = 0;
+        for (int k = 0; k < staticCount; ++k) {
+            __m128i apart = _mm_or_si128(_mm_or_si128(_mm_cmpgt_epi32(x0, _mm_set1_epi32(boxX1[k])),
+                                                      _mm_cmpgt_epi32(_mm_set1_epi32(boxX0[k]), x1)),
+                                         _mm_or_si128(_mm_cmpgt_epi32(y0, _mm_set1_epi32(boxY1[k])),
+                                                      _mm_cmpgt_epi32(_mm_set1_epi32(boxY0[k]), y1)));
+            int hit = ~_mm_movemask_ps(_mm_castsi128_ps(apart)) & 0xF;
+            anyHit |= hit;
+            for (int lane = 0; hit != 0; ++lane, hit >>= 1) {
+                if (hit & 1) {
+                    candidates[lane].set(k);
+                }
+            }
+        }
+
+        // 닿을 상자가 없으면 stepBody도 x += vx, y += vy만 합니다.
+        _mm_store_si128((__m128i*)(x + base), _mm_add_epi32(px, pvx));
+        _mm_store_si128((__m128i*)(y + base), _mm_add_epi32(py, pvy));
+        _mm_store_si128((__m128i*)(vx + base), pvx);
+        _mm_store_si128((__m128i*)(vy + base), pvy);
+        _mm_store_si128((__m128i*)(contacts + base), _mm_setzero_si128());
+        if (anyHit == 0) {
+            return;
+        }
+        // 겹친 월드만 벡터로 쓰기 전의 상태로 되돌려 다시 진행합니다.
+        alignas(16) Fixed oldX[4], oldY[4];
+        _mm_store_si128((__m128i*)oldX, px);
+        _mm_store_si128((__m128i*)oldY, py);
+        for (int lane = 0; lane < 4; ++lane) {
+            if (candidates[lane].any()) {
+                int i = base + lane;
+                x[i] = oldX[lane];
+                y[i] = oldY[lane];
+                vy[i] -= gravity;
+                stepWorld(i, candidates[lane]);
+            }
+        }
+        #else
+        for (int lane = 0; lane < 4; ++lane) {
+            stepWorld(base + lane, CandidateMask().set());
+        }
+        #endif
+    }
+
+    static void stepChunk(void* context, int chunk) {
+        WorldBatch &batch = *(WorldBatch*)context;
+        int end = std::min(batch.padded, (chunk + 1) * WORLD_CHUNK);
+        for (int base = chunk * WORLD_CHUNK; base < end; base += 4) {
+            batch.stepGroup(base);
+        }
+    }
+
+public:
+    Fixed gravity = toFixed(GRAVITY);
+    Fixed bounce = toFixed(BOUND_GRAVITY);
+    long steps = 0;
+
+    // 월드 하나의 상태
+    struct State {
+        Fixed x, y;
+        Fixed vx, vy;
+        unsigned contacts;  // 마지막 스텝에 닿은 면 (1 << CrashCode)
+        int bounces;        // 지금까지 위에 떨어져 튀어 오른 횟수
+    };
+
+    // 모든 월드는 start 상태에서 시작합니다. 상자는 최대 MAX_BLOCKS + 1개까지 씁니다.
+    WorldBatch(int worlds, const Box * level, int levelCount, const Body &start)
+        : count(worlds), padded((worlds + 3) & ~3), staticCount(std::min(levelCount, MAX_BLOCKS + 1)),
+          bodyW(start.w), bodyH(start.h) {
+        x = allocArray<Fixed>(padded);
+        y = allocArray<Fixed>(padded);
+        vx = allocArray<Fixed>(padded);
+        vy = allocArray<Fixed>(padded);
+        input = allocArray<int>(padded);
+        contacts = allocArray<unsigned>(padded);
+        bounces = allocArray<int>(padded);
+        for (int k = 0; k < staticCount; ++k) {
+            statics[k] = level[k];
+            boxX0[k] = level[k].x;
+            boxX1[k] = level[k].x + level[k].w;
+            boxY0[k] = level[k].y;
+            boxY1[k] = level[k].y + level[k].h;
+        }
+        for (int i = 0; i < padded; ++i) {
+            reset(i, start);
+        }
+    }
+    ~WorldBatch() {
+        countedFree(x);
+        countedFree(y);
+        countedFree(vx);
+        countedFree(vy);
+        countedFree(input);
+        countedFree(contacts);
+        countedFree(bounces);
+    }
+    WorldBatch(const WorldBatch &) = delete;
+    WorldBatch &operator=(const WorldBatch &) = delete;
+
+    int size() const {
+        return count;
+    }
+
+    void reset(int world, const Body &start) {
+        x[world] = start.x;
+        y[world] = start.y;
+        vx[world] = start.vx;
+        vy[world] = start.vy;
+        input[world] = fixedToInt(start.vx);
+        contacts[world] = 0;
+        bounces[world] = 0;
+    }
+
+    // 다음 스텝부터 쓸 가로 이동 (틱당 픽셀, 키 입력의 moveVal과 같은 값)
+    void setInput(int world, int move) {
+        input[world] = move;
+    }
+
+    void step(WorkerPool &workers) {
+        workers.run((padded + WORLD_CHUNK - 1) / WORLD_CHUNK, stepChunk, this);
+        steps++;
+    }
+
+    State state(int world) const {
+        return {x[world], y[world], vx[world], vy[world], contacts[world], bounces[world]};
+    }
+};